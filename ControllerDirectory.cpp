@@ -0,0 +1,48 @@
+﻿// =========================
+// File: ControllerDirectory.cpp
+// =========================
+// Online controllers by position: interned position IDs with the callsign and the
+// preformatted frequency of whoever is online there, for the handoff popup and handoffs.
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include "LoaMemory.h"
+#include "LoaNames.h"
+
+const uint16_t ControllerDirectory::kNone;
+
+uint16_t ControllerDirectory::Intern(const char* positionId)
+{
+    std::string key = LoaNameKey(positionId);
+    if (key.empty()) return kNone;
+    auto it = ids.find(key);
+    if (it != ids.end()) return it->second;
+    if (names.size() >= kNone) return kNone;
+
+    const uint16_t id = (uint16_t)names.size();
+    ids.emplace(key, id);
+    names.push_back(std::move(key));
+    contacts.emplace_back();
+    return id;
+}
+
+uint16_t ControllerDirectory::Id(const std::string& positionId) const
+{
+    return FindInternedId(ids, positionId, kNone);
+}
+
+const ControllerContact* ControllerDirectory::Find(const std::string& positionId) const
+{
+    const uint16_t id = Id(positionId);
+    if (id == kNone || contacts[id].callsign.empty()) return nullptr;
+    return &contacts[id];
+}
+
+size_t ControllerDirectory::FootprintBytes() const
+{
+    size_t bytes = LoaMemory::StringKeyedMap(ids) + LoaMemory::Strings(names) +
+        LoaMemory::Vector(contacts);
+    for (const ControllerContact& c : contacts)
+        bytes += LoaMemory::StringHeap(c.callsign) + LoaMemory::StringHeap(c.frequency);
+    return bytes;
+}
@@ -0,0 +1,254 @@
+﻿// =========================
+// File: FlightState.cpp
+// =========================
+// Per-flight state slot map: one FlightState record per callsign, replacing the
+// parallel callsign-keyed caches (route, match, coordination, handoff, tag render).
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include "LoaTrace.h"
+#include "LoaMemory.h"
+#include <cstring>
+
+namespace {
+    static uint32_t HashCallsign(const char* s)
+    {
+        uint32_t h = 2166136261u;
+        for (; *s; ++s) {
+            h ^= (unsigned char)*s;
+            h *= 16777619u;
+        }
+        return h;
+    }
+}
+
+// ---------------- Render slots ----------------
+
+int RenderSlotForItemCode(int itemCode)
+{
+    switch (itemCode) {
+    case ItemCodes::CUSTOM_TAG_ID:             return RENDER_SLOT_XFL;
+    case ItemCodes::CUSTOM_TAG_XFL_DETAILED:   return RENDER_SLOT_XFL_DETAILED;
+    case ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL: return RENDER_SLOT_NEXT_SECTOR;
+    case ItemCodes::CUSTOM_TAG_ID_COP:         return RENDER_SLOT_COP;
+    default:                                   return -1;
+    }
+}
+
+int ItemCodeForRenderSlot(int slot)
+{
+    switch (slot) {
+    case RENDER_SLOT_XFL:          return ItemCodes::CUSTOM_TAG_ID;
+    case RENDER_SLOT_XFL_DETAILED: return ItemCodes::CUSTOM_TAG_XFL_DETAILED;
+    case RENDER_SLOT_NEXT_SECTOR:  return ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL;
+    case RENDER_SLOT_COP:          return ItemCodes::CUSTOM_TAG_ID_COP;
+    default:                       return 0;
+    }
+}
+
+// ---------------- Tag inputs ----------------
+
+TagInputs TagInputs::Read(const EuroScopePlugIn::CFlightPlan& fp, int sectorVersion)
+{
+    TagInputs in;
+    in.clearedAlt = fp.GetClearedAltitude();
+    in.finalAlt = fp.GetFinalAltitude();
+    in.coordAlt = fp.GetExitCoordinationAltitude();
+    in.coordAltState = fp.GetExitCoordinationAltitudeState();
+    const char* coordPt = fp.GetExitCoordinationPointName();
+    strncpy_s(in.coordPoint, sizeof(in.coordPoint), coordPt ? coordPt : "", _TRUNCATE);
+    in.coordPointState = fp.GetExitCoordinationNameState();
+    in.sectorVersion = sectorVersion;
+    return in;
+}
+
+bool TagInputs::operator==(const TagInputs& o) const
+{
+    return clearedAlt == o.clearedAlt &&
+        finalAlt == o.finalAlt &&
+        coordAlt == o.coordAlt &&
+        coordAltState == o.coordAltState &&
+        strncmp(coordPoint, o.coordPoint, sizeof(coordPoint)) == 0 &&
+        coordPointState == o.coordPointState &&
+        sectorVersion == o.sectorVersion;
+}
+
+// ---------------- FlightStateTable ----------------
+
+const uint32_t FlightStateTable::kInvalid;
+
+uint32_t FlightStateTable::Find(const char* callsign) const
+{
+    if (!callsign || table.empty()) return kInvalid;
+    const uint32_t h = HashCallsign(callsign);
+    const size_t mask = table.size() - 1;
+    for (size_t i = Home(h); ; i = (i + 1) & mask) {
+        const uint32_t slot = table[i];
+        if (slot == kInvalid) return kInvalid;
+        if (hashes[slot] == h && strcmp(slots[slot].callsign.c_str(), callsign) == 0) return slot;
+    }
+}
+
+uint32_t FlightStateTable::Acquire(const char* callsign)
+{
+    if (!callsign) return kInvalid;
+    uint32_t slot = Find(callsign);
+    if (slot != kInvalid) return slot;
+
+    // Keep the load factor at or below 1/2
+    if ((live + 1) * 2 > table.size()) {
+        Rehash(table.empty() ? 256 : table.size() * 2);
+    }
+
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = (uint32_t)slots.size();
+        slots.emplace_back();
+        inUse.push_back(0);
+        hashes.push_back(0);
+    }
+
+    const uint32_t h = HashCallsign(callsign);
+    slots[slot].callsign = callsign;
+    inUse[slot] = 1;
+    hashes[slot] = h;
+    ++live;
+
+    const size_t mask = table.size() - 1;
+    size_t i = Home(h);
+    while (table[i] != kInvalid) i = (i + 1) & mask;
+    table[i] = slot;
+    return slot;
+}
+
+void FlightStateTable::Release(uint32_t slot)
+{
+    if (!InUse(slot)) return;
+
+    // Locate the slot in the probe run, then backward-shift delete (no tombstones)
+    const size_t mask = table.size() - 1;
+    size_t hole = Home(hashes[slot]);
+    while (table[hole] != slot) hole = (hole + 1) & mask;
+
+    for (size_t i = (hole + 1) & mask; table[i] != kInvalid; i = (i + 1) & mask) {
+        const size_t home = Home(hashes[table[i]]);
+        const bool homeInRange = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (!homeInRange) {
+            table[hole] = table[i];
+            hole = i;
+        }
+    }
+    table[hole] = kInvalid;
+
+    // Assigning a fresh record frees every buffer the old one owned
+    slots[slot] = FlightState();
+    inUse[slot] = 0;
+    hashes[slot] = 0;
+    freeSlots.push_back(slot);
+    --live;
+}
+
+void FlightStateTable::Rehash(size_t newCapacity)
+{
+    table.assign(newCapacity, kInvalid);
+    const size_t mask = newCapacity - 1;
+    for (uint32_t slot = 0; slot < (uint32_t)slots.size(); ++slot) {
+        if (!inUse[slot]) continue;
+        size_t i = Home(hashes[slot]);
+        while (table[i] != kInvalid) i = (i + 1) & mask;
+        table[i] = slot;
+    }
+}
+
+size_t FlightStateTable::IndexBytes() const
+{
+    return LoaMemory::Vector(inUse) + LoaMemory::Vector(hashes) +
+        LoaMemory::Vector(freeSlots) + LoaMemory::Vector(table);
+}
+
+size_t FlightStateTable::FootprintBytes() const
+{
+    size_t bytes = slots.size() * sizeof(FlightState) + IndexBytes();
+
+    for (uint32_t slot = 0; slot < (uint32_t)slots.size(); ++slot) {
+        if (!inUse[slot]) continue;
+        const FlightState& fs = slots[slot];
+        bytes += LoaMemory::StringHeap(fs.callsign);
+        bytes += LoaMemory::Strings(fs.routePoints);
+        bytes += LoaMemory::StringSet(fs.routeSet);
+        bytes += LoaMemory::StringHeap(fs.lastDestination);
+        bytes += LoaMemory::StringHeap(fs.activeHandoffTarget);
+        bytes += LoaMemory::StringHeap(fs.frame.callsign);
+        bytes += LoaMemory::StringHeap(fs.frame.origin);
+        bytes += LoaMemory::StringHeap(fs.frame.destination);
+        bytes += LoaMemory::StringHeap(fs.coordination.baselineExitPoint);
+        bytes += LoaMemory::StringHeap(fs.coordination.pendingExitPoint);
+        bytes += LoaMemory::StringHeap(fs.coordination.acceptedExitPoint);
+        bytes += LoaMemory::StringHeap(fs.cop.baselineValue);
+        bytes += LoaMemory::StringHeap(fs.cop.pendingValue);
+    }
+    return bytes;
+}
+
+// ---------------- LOAPlugin glue ----------------
+
+FlightState& LOAPlugin::GetFlightState(const EuroScopePlugIn::CFlightPlan& fp)
+{
+    const char* cs = fp.GetCallsign();
+    if (!cs) cs = "";
+
+    // Consecutive callbacks are almost always for the same flight: skip the hash
+    uint32_t slot = lastFlightStateSlot;
+    if (!flightStates.InUse(slot) || strcmp(flightStates[slot].callsign.c_str(), cs) != 0) {
+        slot = flightStates.Acquire(cs);
+        lastFlightStateSlot = slot;
+    }
+
+    FlightState& fs = flightStates[slot];
+    fs.lastSeenMs = GetTickCount64();
+    return fs;
+}
+
+FlightState* LOAPlugin::FindFlightState(const std::string& callsign)
+{
+    const uint32_t slot = flightStates.Find(callsign.c_str());
+    return (slot != FlightStateTable::kInvalid) ? &flightStates[slot] : nullptr;
+}
+
+void LOAPlugin::ResetFlightStates(unsigned what)
+{
+    LOA_TRACE_SCOPE("cache", "ResetFlightStates");
+    flightStates.ForEach([&](uint32_t, FlightState& fs) {
+        if (what & FS_RESET_MATCH) fs.ResetMatch();
+        if (what & FS_RESET_ROUTE) fs.ResetRoute();
+        if (what & FS_RESET_ROUTE_SIGNATURE) fs.hasRouteSignature = false;
+        if (what & FS_RESET_COORDINATION) fs.coordination = CoordinationInfo();
+        if (what & FS_RESET_RENDER) fs.ResetRender();
+        if (what & FS_RESET_LAST_DESTINATION) fs.hasLastDestination = false;
+        });
+}
+
+void LOAPlugin::InvalidateRenderItem(const std::string& callsign, int itemCode)
+{
+    const int slot = RenderSlotForItemCode(itemCode);
+    if (slot < 0) return;
+    if (FlightState* fs = FindFlightState(callsign)) {
+        // Siblings stay valid; only this item re-renders on its next request
+        for (TagBundle& b : fs->bundles) b.validMask &= ~(1u << slot);
+    }
+}
+
+void LOAPlugin::ReportFlightStateMemory()
+{
+    char buf[256];
+    sprintf_s(buf, sizeof(buf),
+        "FlightState: %u bytes/record, %u live, %u slots, ~%u KB total",
+        (unsigned)sizeof(FlightState),
+        (unsigned)flightStates.Size(),
+        (unsigned)flightStates.Capacity(),
+        (unsigned)((flightStates.FootprintBytes() + 1023) / 1024));
+    DisplayUserMessage("LOA Plugin", "Memory", buf, true, true, false, false, false);
+}
@@ -4,6 +4,9 @@
 
 #include "stdafx.h"
 #include "LOAPlugin.h"
+#include "LoaStats.h"
+#include "LoaTrace.h"
+#include "LoaNames.h"
 #define NOMINMAX
 #include <windows.h>
 #include <fstream>
@@ -14,6 +17,9 @@
 #include <cctype>   // for std::toupper
 #include <cmath>
 #include <cstdlib>
+#include <thread>
+#include <chrono>
+#include <climits>
 
 #pragma comment(lib, "Gdi32.lib")
 #pragma comment(lib, "User32.lib")
@@ -29,6 +35,16 @@ static std::string AddArrowPrefix(const std::string& text)
 
 extern "C" IMAGE_DOS_HEADER __ImageBase;
 
+// Folder containing the plugin DLL; configs (loa_configs_json) and dumps live there
+static std::string PluginFolder()
+{
+    char dllPath[MAX_PATH];
+    GetModuleFileNameA(HINSTANCE(&__ImageBase), dllPath, sizeof(dllPath));
+    std::string basePath(dllPath);
+    size_t lastSlash = basePath.find_last_of("\\/");
+    return (lastSlash != std::string::npos) ? basePath.substr(0, lastSlash) : ".";
+}
+
 // ============================================================================
 // TopSky-style custom sector handoff popup
 // - This replaces EuroScope OpenPopupList only for the visual list.
@@ -113,6 +129,60 @@ namespace {
         if (g_cachedFreqFont)   { DeleteObject(g_cachedFreqFont);   g_cachedFreqFont   = NULL; }
     }
 
+    // Row geometry for one popup shape (the sequence of row kinds), measured once per style
+    // and shared by painting, hit testing and placement.
+    struct CustomHandoffLayout {
+        std::vector<RECT> rowRects;   // client coordinates, one per row
+        int visibleRows = 0;
+        int headerHeight = 0;
+        int height = 0;
+    };
+    static std::unordered_map<std::string, CustomHandoffLayout> g_handoffLayouts; // key: row kinds
+    static const CustomHandoffLayout* g_handoffLayout = nullptr;                  // layout of g_handoffRows
+
+    // Off-screen copy of the popup: rendered in full when new rows are shown, then only
+    // the rows whose hover/selection changed are redrawn into it and blitted.
+    static HDC g_backDC = NULL;
+    static HBITMAP g_backBitmap = NULL;
+    static HGDIOBJ g_backOldBitmap = NULL;
+    static int g_backWidth = 0;
+    static int g_backHeight = 0;
+    static bool g_backDirty = true;
+
+    static void DestroyPopupBackBuffer()
+    {
+        if (g_backDC) {
+            SelectObject(g_backDC, g_backOldBitmap);
+            DeleteDC(g_backDC);
+            g_backDC = NULL;
+        }
+        if (g_backBitmap) { DeleteObject(g_backBitmap); g_backBitmap = NULL; }
+        g_backOldBitmap = NULL;
+        g_backWidth = g_backHeight = 0;
+        g_backDirty = true;
+    }
+
+    static bool EnsurePopupBackBuffer(HWND hwnd, int width, int height)
+    {
+        if (g_backDC && width <= g_backWidth && height <= g_backHeight)
+            return true;
+
+        DestroyPopupBackBuffer();
+        HDC windowDC = GetDC(hwnd);
+        if (!windowDC) return false;
+        g_backDC = CreateCompatibleDC(windowDC);
+        g_backBitmap = g_backDC ? CreateCompatibleBitmap(windowDC, width, height) : NULL;
+        ReleaseDC(hwnd, windowDC);
+        if (!g_backBitmap) {
+            DestroyPopupBackBuffer();
+            return false; // WM_PAINT draws straight to the window instead
+        }
+        g_backOldBitmap = SelectObject(g_backDC, g_backBitmap);
+        g_backWidth = width;
+        g_backHeight = height;
+        return true;
+    }
+
     static int ClampColorByte(int v)
     {
         if (v < 0) return 0;
@@ -134,6 +204,9 @@ namespace {
         g_handoffHoverIndex = -1;
         g_handoffHoverSubIndex = -1;
         g_selectedReleaseSubIndex = 0;
+        g_handoffLayout = nullptr;
+        g_handoffLayouts.clear();
+        DestroyPopupBackBuffer();
         DestroyPopupFonts();
     }
 
@@ -148,6 +221,20 @@ namespace {
         return RGB((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
     }
 
+    // Refresh budget in ms: a whole number from 0 (unlimited) up to one refresh interval
+    static bool ParseRefreshBudgetMs(const char* text, int& out)
+    {
+        if (!text) return false;
+        while (*text == ' ') ++text;
+        if (!*text) return false;
+        char* end = nullptr;
+        const long ms = std::strtol(text, &end, 10);
+        while (end && *end == ' ') ++end;
+        if (!end || *end != '\0' || ms < 0 || ms > 1000) return false;
+        out = (int)ms;
+        return true;
+    }
+
     static COLORREF ParseJsonColor(const json& value, COLORREF fallback)
     {
         // Preferred config format:
@@ -177,13 +264,7 @@ namespace {
         if (g_popupStyleLoaded) return;
         g_popupStyleLoaded = true;
 
-        char dllPath[MAX_PATH];
-        GetModuleFileNameA(HINSTANCE(&__ImageBase), dllPath, sizeof(dllPath));
-        std::string basePath(dllPath);
-        size_t lastSlash = basePath.find_last_of("\\/");
-        basePath = (lastSlash != std::string::npos) ? basePath.substr(0, lastSlash) : ".";
-
-        const std::string filePath = basePath + "\\loa_configs_json\\custom_handoff_popup.json";
+        const std::string filePath = PluginFolder() + "\\loa_configs_json\\custom_handoff_popup.json";
         std::ifstream in(filePath.c_str());
         if (!in.is_open()) {
             // Optional file. Defaults are used if it is missing.
@@ -259,9 +340,9 @@ namespace {
 
     static EuroScopePlugIn::CFlightPlan FindFlightPlanByCallsign(const std::string& callsign)
     {
-        for (EuroScopePlugIn::CFlightPlan fp = plugin.FlightPlanSelectFirst();
+        for (EuroScopePlugIn::CFlightPlan fp = pMyPlugIn->FlightPlanSelectFirst();
             fp.IsValid();
-            fp = plugin.FlightPlanSelectNext(fp))
+            fp = pMyPlugIn->FlightPlanSelectNext(fp))
         {
             if (_stricmp(fp.GetCallsign(), callsign.c_str()) == 0)
                 return fp;
@@ -306,7 +387,7 @@ namespace {
 
         if (row.action == CustomHandoffAction::Release) {
             const char* trackingId = fp.GetTrackingControllerId();
-            std::string myPosId = plugin.ControllerMyself().GetPositionId();
+            std::string myPosId = pMyPlugIn->ControllerMyself().GetPositionId();
 
             if (trackingId && trackingId[0] &&
                 _stricmp(trackingId, myPosId.c_str()) == 0)
@@ -328,10 +409,9 @@ namespace {
                 // Keep the existing Next Sector tag behavior: show the chosen sector
                 // while TRANSFER_FROM_ME_INITIATED.
                 std::string cs = fp.GetCallsign();
-                plugin.activeHandoffTargets[cs] = row.sectorId;
+                pMyPlugIn->GetFlightState(fp).activeHandoffTarget = row.sectorId;
 
-                std::string key = cs + ":" + std::to_string(ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL);
-                plugin.renderCache.erase(key);
+                pMyPlugIn->InvalidateRenderItem(cs, ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL);
             }
             return;
         }
@@ -341,26 +421,6 @@ namespace {
     }
 
 
-    static bool CustomPopupHasAssumeRow()
-    {
-        for (size_t i = 0; i < g_handoffRows.size(); ++i) {
-            if (g_handoffRows[i].action == CustomHandoffAction::Assume ||
-                g_handoffRows[i].action == CustomHandoffAction::ReleaseBar)
-                return true;
-        }
-        return false;
-    }
-
-    static int GetEffectiveHeaderHeight()
-    {
-        // When ASSUME is not available, there is no Section 1 button.
-        // Compact the header so Section 2 starts directly below the title area.
-        return CustomPopupHasAssumeRow()
-            ? g_popupStyle.headerHeight
-            : 28;
-    }
-
-
     static int GetCustomHandoffRowHeight(const CustomHandoffRow& row)
     {
         if (row.action == CustomHandoffAction::Separator)
@@ -369,48 +429,68 @@ namespace {
         return g_popupStyle.rowHeight;
     }
 
-    static int GetCustomHandoffRowsHeight(const std::vector<CustomHandoffRow>& rows, int maxVisibleRows)
+    static const CustomHandoffLayout& GetCustomHandoffLayout(const std::vector<CustomHandoffRow>& rows)
     {
-        int total = 0;
-
-        for (int i = 0; i < (int)rows.size() && i < maxVisibleRows; ++i) {
-            total += GetCustomHandoffRowHeight(rows[i]);
+        std::string key;
+        key.reserve(rows.size());
+        bool hasAssumeRow = false;
+        for (const CustomHandoffRow& row : rows) {
+            key.push_back((char)('0' + (int)row.action));
+            if (row.action == CustomHandoffAction::Assume || row.action == CustomHandoffAction::ReleaseBar)
+                hasAssumeRow = true;
         }
 
-        return total;
-    }
+        auto it = g_handoffLayouts.find(key);
+        if (it != g_handoffLayouts.end())
+            return it->second;
 
-    static int GetCustomHandoffRowTop(int rowIndex)
-    {
-        int y = 0;
+        CustomHandoffLayout layout;
+
+        // When ASSUME is not available, there is no Section 1 button.
+        // Compact the header so Section 2 starts directly below the title area.
+        layout.headerHeight = hasAssumeRow ? g_popupStyle.headerHeight : 28;
 
-        for (int i = 0; i < rowIndex && i < (int)g_handoffRows.size(); ++i) {
-            y += GetCustomHandoffRowHeight(g_handoffRows[i]);
+        const int left = g_popupStyle.popupBorder + 4;
+        const int right = g_popupStyle.popupWidth - g_popupStyle.popupBorder - 4;
+        int y = layout.headerHeight + g_popupStyle.listVerticalPadding;
+        int rowsHeight = 0;
+
+        layout.rowRects.reserve(rows.size());
+        for (int i = 0; i < (int)rows.size(); ++i) {
+            const int rowH = GetCustomHandoffRowHeight(rows[i]);
+            RECT rr{ left, y, right, y + rowH };
+            layout.rowRects.push_back(rr);
+            y += rowH;
+            if (i < g_popupStyle.maxVisibleRows) rowsHeight += rowH;
         }
+        layout.visibleRows = (int)std::min<size_t>(rows.size(), g_popupStyle.maxVisibleRows);
+
+        // Use a smaller bottom padding so the visual gap above/below the list appears equal.
+        const int bottomPadding = 1;
+        layout.height =
+            layout.headerHeight +
+            g_popupStyle.listVerticalPadding +
+            bottomPadding +
+            rowsHeight +
+            (g_popupStyle.popupBorder * 2);
 
-        return y;
+        return g_handoffLayouts.emplace(key, std::move(layout)).first->second;
     }
 
     static int RowFromPointY(int y)
     {
-        const int listTop = GetEffectiveHeaderHeight() + g_popupStyle.listVerticalPadding;
-
-        if (y < listTop)
+        if (!g_handoffLayout)
             return -1;
 
-        int curY = listTop;
-
-        for (int i = 0; i < (int)g_handoffRows.size() && i < g_popupStyle.maxVisibleRows; ++i) {
-            const int rowH = GetCustomHandoffRowHeight(g_handoffRows[i]);
+        for (int i = 0; i < g_handoffLayout->visibleRows; ++i) {
+            const RECT& rr = g_handoffLayout->rowRects[i];
 
-            if (y >= curY && y < curY + rowH) {
+            if (y >= rr.top && y < rr.bottom) {
                 if (g_handoffRows[i].action == CustomHandoffAction::Separator)
                     return -1;
 
                 return i;
             }
-
-            curY += rowH;
         }
 
         return -1;
@@ -441,6 +521,193 @@ namespace {
         SelectObject(hdc, oldFont);
     }
 
+    static void DrawCustomHandoffRow(HDC hdc, int i)
+    {
+        const CustomHandoffRow& row = g_handoffRows[i];
+        const RECT& rr = g_handoffLayout->rowRects[i];
+        const int rowH = rr.bottom - rr.top;
+
+        HFONT rowFont  = g_cachedRowFont;
+        HFONT freqFont = g_cachedFreqFont;
+
+        if (row.action == CustomHandoffAction::Separator) {
+            HPEN p = CreatePen(PS_SOLID, 1, g_popupStyle.separatorColor);
+            HGDIOBJ op = SelectObject(hdc, p);
+            const int midY = rr.top + (rowH / 2);
+            MoveToEx(hdc, rr.left, midY, NULL);
+            LineTo(hdc, rr.right, midY);
+            SelectObject(hdc, op);
+            DeleteObject(p);
+            return;
+        }
+
+        // ---- ReleaseBar: four small buttons side by side ----
+        if (row.action == CustomHandoffAction::ReleaseBar) {
+            // Fill row background
+            HBRUSH rowBg = CreateSolidBrush(g_popupStyle.backgroundColor);
+            FillRect(hdc, &rr, rowBg);
+            DeleteObject(rowBg);
+
+            const int totalW = rr.right - rr.left;
+            const int btnW = totalW / kReleaseBarCount;
+            const int btnGap = 3;  // horizontal gap between mini-buttons
+
+            // Active/selected button colour: use hover background with a visible border.
+            const COLORREF selectedBg = g_popupStyle.hoverBackgroundColor;
+            const COLORREF selectedTxt = g_popupStyle.hoverTextColor;
+
+            for (int b = 0; b < kReleaseBarCount; ++b) {
+                const bool isSelected = (b == g_selectedReleaseSubIndex);
+                const bool btnHover = (i == g_handoffHoverIndex && b == g_handoffHoverSubIndex);
+
+                COLORREF btnBg = isSelected ? selectedBg
+                    : btnHover ? RGB(200, 200, 200)  // lighter hover when not selected
+                    : g_popupStyle.buttonBackgroundColor;
+                COLORREF txtCol = isSelected ? selectedTxt
+                    : g_popupStyle.normalTextColor;
+
+                RECT btn;
+                btn.left = rr.left + b * btnW + btnGap;
+                btn.right = rr.left + (b + 1) * btnW - btnGap;
+                btn.top = rr.top + 3;
+                btn.bottom = rr.bottom - 3;
+
+                HPEN   bPen = CreatePen(PS_SOLID, isSelected ? 2 : 1,
+                    isSelected ? RGB(40, 40, 40)
+                    : btnHover ? RGB(80, 80, 80)
+                    : RGB(120, 120, 120));
+                HBRUSH bBrush = CreateSolidBrush(btnBg);
+
+                HGDIOBJ oPen = SelectObject(hdc, bPen);
+                HGDIOBJ oBrush = SelectObject(hdc, bBrush);
+
+                RoundRect(hdc, btn.left, btn.top, btn.right, btn.bottom, 6, 6);
+
+                SelectObject(hdc, oBrush);
+                SelectObject(hdc, oPen);
+                DeleteObject(bBrush);
+                DeleteObject(bPen);
+
+                DrawCenteredText(hdc, kReleaseBarLabels[b], btn, txtCol, rowFont);
+            }
+            return;
+        }
+
+        const bool hover = (i == g_handoffHoverIndex);
+
+        // The full row uses the popup background. The inner rounded rectangle is the actual button.
+        COLORREF rowBgColor = g_popupStyle.backgroundColor;
+        COLORREF buttonBgColor = hover ? g_popupStyle.hoverBackgroundColor : g_popupStyle.buttonBackgroundColor;
+        COLORREF textColor = hover ? g_popupStyle.hoverTextColor : g_popupStyle.normalTextColor;
+
+        HBRUSH rowBg = CreateSolidBrush(rowBgColor);
+        FillRect(hdc, &rr, rowBg);
+        DeleteObject(rowBg);
+
+        // Draw each selectable entry as a rounded button.
+        // Separators are skipped earlier, so this applies to ASSUME, sector rows, and FREE.
+        RECT box = rr;
+        InflateRect(&box, -2, -1);
+
+        HPEN boxPen = CreatePen(PS_SOLID, 1, hover
+            ? RGB(40, 40, 40)
+            : RGB(120, 120, 120));
+
+        HBRUSH boxBrush = CreateSolidBrush(buttonBgColor);
+
+        HGDIOBJ oldBoxPen = SelectObject(hdc, boxPen);
+        HGDIOBJ oldBoxBrush = SelectObject(hdc, boxBrush);
+
+        RoundRect(
+            hdc,
+            box.left,
+            box.top,
+            box.right,
+            box.bottom,
+            8,
+            8);
+
+        SelectObject(hdc, oldBoxBrush);
+        SelectObject(hdc, oldBoxPen);
+
+        DeleteObject(boxBrush);
+        DeleteObject(boxPen);
+
+        if (row.action == CustomHandoffAction::Sector && !row.frequency.empty()) {
+            RECT sectorRect = rr;
+            sectorRect.bottom = rr.top + (g_popupStyle.rowHeight / 2) + 3;
+
+            RECT freqRect = rr;
+            freqRect.top = rr.top + (g_popupStyle.rowHeight / 2) - 3;
+
+            DrawCenteredText(hdc, row.label, sectorRect, textColor, rowFont);
+            DrawCenteredText(hdc, row.frequency, freqRect, textColor, freqFont);
+        }
+        else {
+            DrawCenteredText(hdc, row.label, rr, textColor, rowFont);
+        }
+    }
+
+    static void DrawCustomHandoffPopup(HDC hdc, const RECT& client)
+    {
+        // soft popup shadow
+        RECT shadow = client;
+        OffsetRect(&shadow, 3, 3);
+
+        HBRUSH shadowBrush = CreateSolidBrush(RGB(0, 0, 255));
+        FillRect(hdc, &shadow, shadowBrush);
+        DeleteObject(shadowBrush);
+
+        HBRUSH bg = CreateSolidBrush(g_popupStyle.backgroundColor);
+        FillRect(hdc, &client, bg);
+        DeleteObject(bg);
+
+        HPEN borderPen = CreatePen(PS_SOLID, 1, g_popupStyle.borderColor);
+        HGDIOBJ oldPen = SelectObject(hdc, borderPen);
+        HGDIOBJ oldBrush = SelectObject(hdc, GetStockObject(NULL_BRUSH));
+
+        // Draw the border inset by one pixel so it is visually even on all sides.
+        // Rectangle() treats right/bottom differently, so avoid using client.right/client.bottom directly.
+        RECT borderRect = client;
+        borderRect.left += 1;
+        borderRect.top += 1;
+        borderRect.right -= 1;
+        borderRect.bottom -= 1;
+
+        Rectangle(hdc, borderRect.left, borderRect.top, borderRect.right, borderRect.bottom);
+
+        SelectObject(hdc, oldBrush);
+        SelectObject(hdc, oldPen);
+        DeleteObject(borderPen);
+
+        EnsurePopupFonts();
+        HFONT headerFont = g_cachedHeaderFont;
+
+        std::string callsign;
+        if (!g_handoffRows.empty())
+            callsign = g_handoffRows.front().callsign;
+
+        RECT r1{ 4, 5, client.right - 4, 24 };
+
+        DrawCenteredText(hdc, callsign, r1, g_popupStyle.headerTextColor, headerFont);
+
+        for (int i = 0; i < g_handoffLayout->visibleRows; ++i)
+            DrawCustomHandoffRow(hdc, i);
+    }
+
+    // Redraw rows a and b (e.g. old and new hover) into the back buffer and repaint only them
+    static void RedrawCustomHandoffRows(HWND hwnd, int a, int b)
+    {
+        if (!g_handoffLayout) return;
+        const int rows[2] = { a, b };
+        for (int k = 0; k < 2; ++k) {
+            const int i = rows[k];
+            if (i < 0 || i >= g_handoffLayout->visibleRows || (k == 1 && i == a)) continue;
+            if (g_backDC && !g_backDirty) DrawCustomHandoffRow(g_backDC, i);
+            InvalidateRect(hwnd, &g_handoffLayout->rowRects[i], FALSE);
+        }
+    }
+
     static LRESULT CALLBACK CustomHandoffPopupProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     {
         switch (msg) {
@@ -474,9 +741,10 @@ namespace {
             }
 
             if (idx != g_handoffHoverIndex || subIdx != g_handoffHoverSubIndex) {
+                const int previous = g_handoffHoverIndex;
                 g_handoffHoverIndex = idx;
                 g_handoffHoverSubIndex = subIdx;
-                InvalidateRect(hwnd, NULL, FALSE);
+                RedrawCustomHandoffRows(hwnd, previous, idx);
             }
             return 0;
         }
@@ -534,15 +802,16 @@ namespace {
 
                     // Only update the selection; keep popup open so user can still pick a sector.
                     ExecuteReleaseBarButton(sub);
-                    InvalidateRect(hwnd, NULL, FALSE);
+                    RedrawCustomHandoffRows(hwnd, idx, idx);
                     // Do NOT set the close timer.
                 }
                 else {
                     CustomHandoffRow rowCopy = row;
 
+                    const int previous = g_handoffHoverIndex;
                     g_handoffHoverIndex = idx;
                     g_handoffHoverSubIndex = -1;
-                    InvalidateRect(hwnd, NULL, FALSE);
+                    RedrawCustomHandoffRows(hwnd, previous, idx);
 
                     ExecuteCustomHandoffRow(rowCopy);
 
@@ -567,184 +836,21 @@ namespace {
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hwnd, &ps);
 
-            RECT client = {};
-            GetClientRect(hwnd, &client);
-
-            // soft popup shadow
-            RECT shadow = client;
-            OffsetRect(&shadow, 3, 3);
-
-            HBRUSH shadowBrush = CreateSolidBrush(RGB(0, 0, 255));
-            FillRect(hdc, &shadow, shadowBrush);
-            DeleteObject(shadowBrush);
-
-            HBRUSH bg = CreateSolidBrush(g_popupStyle.backgroundColor);
-            FillRect(hdc, &client, bg);
-            DeleteObject(bg);
-
-            HPEN borderPen = CreatePen(PS_SOLID, 1, g_popupStyle.borderColor);
-            HGDIOBJ oldPen = SelectObject(hdc, borderPen);
-            HGDIOBJ oldBrush = SelectObject(hdc, GetStockObject(NULL_BRUSH));
-
-            // Draw the border inset by one pixel so it is visually even on all sides.
-            // Rectangle() treats right/bottom differently, so avoid using client.right/client.bottom directly.
-            RECT borderRect = client;
-            borderRect.left += 1;
-            borderRect.top += 1;
-            borderRect.right -= 1;
-            borderRect.bottom -= 1;
-
-            Rectangle(hdc, borderRect.left, borderRect.top, borderRect.right, borderRect.bottom);
-
-            SelectObject(hdc, oldBrush);
-            SelectObject(hdc, oldPen);
-            DeleteObject(borderPen);
-
-            EnsurePopupFonts();
-            HFONT headerFont = g_cachedHeaderFont;
-            HFONT rowFont    = g_cachedRowFont;
-            HFONT freqFont   = g_cachedFreqFont;
-
-            std::string callsign;
-            if (!g_handoffRows.empty())
-                callsign = g_handoffRows.front().callsign;
-
-            const int effectiveHeaderHeight = GetEffectiveHeaderHeight();
+            if (g_handoffLayout) {
+                RECT client = {};
+                GetClientRect(hwnd, &client);
 
-            RECT r1{ 4, 5, client.right - 4, 24 };
-
-            DrawCenteredText(hdc, callsign, r1, g_popupStyle.headerTextColor, headerFont);
-
-            int currentRowY = effectiveHeaderHeight + g_popupStyle.listVerticalPadding;
-
-            for (int i = 0; i < (int)g_handoffRows.size() && i < g_popupStyle.maxVisibleRows; ++i) {
-                const CustomHandoffRow& row = g_handoffRows[i];
-                const int rowH = GetCustomHandoffRowHeight(row);
-
-                RECT rr{
-                    g_popupStyle.popupBorder + 4,
-                    currentRowY,
-                    client.right - g_popupStyle.popupBorder - 4,
-                    currentRowY + rowH
-                };
-
-                currentRowY += rowH;
-
-                if (row.action == CustomHandoffAction::Separator) {
-                    HPEN p = CreatePen(PS_SOLID, 1, g_popupStyle.separatorColor);
-                    HGDIOBJ op = SelectObject(hdc, p);
-                    const int midY = rr.top + (rowH / 2);
-                    MoveToEx(hdc, rr.left, midY, NULL);
-                    LineTo(hdc, rr.right, midY);
-                    SelectObject(hdc, op);
-                    DeleteObject(p);
-                    continue;
-                }
-
-                // ---- ReleaseBar: four small buttons side by side ----
-                if (row.action == CustomHandoffAction::ReleaseBar) {
-                    // Fill row background
-                    HBRUSH rowBg = CreateSolidBrush(g_popupStyle.backgroundColor);
-                    FillRect(hdc, &rr, rowBg);
-                    DeleteObject(rowBg);
-
-                    const int totalW = rr.right - rr.left;
-                    const int btnW = totalW / kReleaseBarCount;
-                    const int btnGap = 3;  // horizontal gap between mini-buttons
-
-                    // Active/selected button colour: use hover background with a visible border.
-                    const COLORREF selectedBg = g_popupStyle.hoverBackgroundColor;
-                    const COLORREF selectedTxt = g_popupStyle.hoverTextColor;
-
-                    for (int b = 0; b < kReleaseBarCount; ++b) {
-                        const bool isSelected = (b == g_selectedReleaseSubIndex);
-                        const bool btnHover = (i == g_handoffHoverIndex && b == g_handoffHoverSubIndex);
-
-                        COLORREF btnBg = isSelected ? selectedBg
-                            : btnHover ? RGB(200, 200, 200)  // lighter hover when not selected
-                            : g_popupStyle.buttonBackgroundColor;
-                        COLORREF txtCol = isSelected ? selectedTxt
-                            : g_popupStyle.normalTextColor;
-
-                        RECT btn;
-                        btn.left = rr.left + b * btnW + btnGap;
-                        btn.right = rr.left + (b + 1) * btnW - btnGap;
-                        btn.top = rr.top + 3;
-                        btn.bottom = rr.bottom - 3;
-
-                        HPEN   bPen = CreatePen(PS_SOLID, isSelected ? 2 : 1,
-                            isSelected ? RGB(40, 40, 40)
-                            : btnHover ? RGB(80, 80, 80)
-                            : RGB(120, 120, 120));
-                        HBRUSH bBrush = CreateSolidBrush(btnBg);
-
-                        HGDIOBJ oPen = SelectObject(hdc, bPen);
-                        HGDIOBJ oBrush = SelectObject(hdc, bBrush);
-
-                        RoundRect(hdc, btn.left, btn.top, btn.right, btn.bottom, 6, 6);
-
-                        SelectObject(hdc, oBrush);
-                        SelectObject(hdc, oPen);
-                        DeleteObject(bBrush);
-                        DeleteObject(bPen);
-
-                        DrawCenteredText(hdc, kReleaseBarLabels[b], btn, txtCol, rowFont);
+                if (g_backDC) {
+                    if (g_backDirty) {
+                        DrawCustomHandoffPopup(g_backDC, client);
+                        g_backDirty = false;
                     }
-                    continue;
-                }
-
-                const bool hover = (i == g_handoffHoverIndex);
-
-                // The full row uses the popup background. The inner rounded rectangle is the actual button.
-                COLORREF rowBgColor = g_popupStyle.backgroundColor;
-                COLORREF buttonBgColor = hover ? g_popupStyle.hoverBackgroundColor : g_popupStyle.buttonBackgroundColor;
-                COLORREF textColor = hover ? g_popupStyle.hoverTextColor : g_popupStyle.normalTextColor;
-
-                HBRUSH rowBg = CreateSolidBrush(rowBgColor);
-                FillRect(hdc, &rr, rowBg);
-                DeleteObject(rowBg);
-
-                // Draw each selectable entry as a rounded button.
-                // Separators are skipped earlier, so this applies to ASSUME, sector rows, and FREE.
-                RECT box = rr;
-                InflateRect(&box, -2, -1);
-
-                HPEN boxPen = CreatePen(PS_SOLID, 1, hover
-                    ? RGB(40, 40, 40)
-                    : RGB(120, 120, 120));
-
-                HBRUSH boxBrush = CreateSolidBrush(buttonBgColor);
-
-                HGDIOBJ oldBoxPen = SelectObject(hdc, boxPen);
-                HGDIOBJ oldBoxBrush = SelectObject(hdc, boxBrush);
-
-                RoundRect(
-                    hdc,
-                    box.left,
-                    box.top,
-                    box.right,
-                    box.bottom,
-                    8,
-                    8);
-
-                SelectObject(hdc, oldBoxBrush);
-                SelectObject(hdc, oldBoxPen);
-
-                DeleteObject(boxBrush);
-                DeleteObject(boxPen);
-
-                if (row.action == CustomHandoffAction::Sector && !row.frequency.empty()) {
-                    RECT sectorRect = rr;
-                    sectorRect.bottom = rr.top + (g_popupStyle.rowHeight / 2) + 3;
-
-                    RECT freqRect = rr;
-                    freqRect.top = rr.top + (g_popupStyle.rowHeight / 2) - 3;
-
-                    DrawCenteredText(hdc, row.label, sectorRect, textColor, rowFont);
-                    DrawCenteredText(hdc, row.frequency, freqRect, textColor, freqFont);
+                    BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top,
+                        ps.rcPaint.right - ps.rcPaint.left, ps.rcPaint.bottom - ps.rcPaint.top,
+                        g_backDC, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
                 }
                 else {
-                    DrawCenteredText(hdc, row.label, rr, textColor, rowFont);
+                    DrawCustomHandoffPopup(hdc, client);
                 }
             }
 
@@ -794,8 +900,29 @@ namespace {
             NULL);
     }
 
+    // Tallest popup the style allows; the back buffer is allocated for it up front
+    static int GetMaxCustomHandoffPopupHeight()
+    {
+        return g_popupStyle.headerHeight + g_popupStyle.listVerticalPadding + 1 +
+            g_popupStyle.maxVisibleRows * g_popupStyle.rowHeight + (g_popupStyle.popupBorder * 2);
+    }
+
+    // Style, window, fonts and back buffer before the first tag click of a session, so that
+    // click only fills in rows. Called from the first OnTimer, never from the constructor:
+    // the global instance is constructed during DLL static init, under the loader lock.
+    static void PrewarmCustomHandoffPopup()
+    {
+        EnsureCustomHandoffPopupWindow();
+        if (!g_handoffPopupWnd)
+            return;
+
+        EnsurePopupFonts();
+        EnsurePopupBackBuffer(g_handoffPopupWnd, g_popupStyle.popupWidth, GetMaxCustomHandoffPopupHeight());
+    }
+
     static void ShowCustomHandoffPopup(POINT pt, const std::vector<CustomHandoffRow>& rows)
     {
+        LOA_TRACE_SCOPE("popup", "ShowCustomHandoffPopup");
         POINT mousePt;
         GetCursorPos(&mousePt);
         pt = mousePt;
@@ -814,18 +941,8 @@ namespace {
         g_handoffHoverSubIndex = -1;
         g_selectedReleaseSubIndex = 0;  // default: F (Full) pre-selected
 
-        const int visibleRows = (int)std::min<size_t>(g_handoffRows.size(), g_popupStyle.maxVisibleRows);
-        // Use a smaller bottom padding so the visual gap above/below the list appears equal.
-        const int bottomPadding = 1;
-        const int effectiveHeaderHeight = GetEffectiveHeaderHeight();
-        const int rowsHeight = GetCustomHandoffRowsHeight(g_handoffRows, g_popupStyle.maxVisibleRows);
-
-        const int height =
-            effectiveHeaderHeight +
-            g_popupStyle.listVerticalPadding +
-            bottomPadding +
-            rowsHeight +
-            (g_popupStyle.popupBorder * 2);
+        g_handoffLayout = &GetCustomHandoffLayout(g_handoffRows);
+        const int height = g_handoffLayout->height;
 
         // Anchor row: the row that will be centred under the mouse cursor when the popup opens.
         // In ASSUMED state the user most likely wants to hand off immediately, so anchor to the
@@ -890,8 +1007,9 @@ namespace {
             }
         }
 
+        const RECT& anchorRect = g_handoffLayout->rowRects[anchorRow];
         int x = pt.x - (g_popupStyle.popupWidth / 2);
-        int y = pt.y - effectiveHeaderHeight - g_popupStyle.listVerticalPadding - GetCustomHandoffRowTop(anchorRow) - (GetCustomHandoffRowHeight(g_handoffRows[anchorRow]) / 2);
+        int y = pt.y - anchorRect.top - ((anchorRect.bottom - anchorRect.top) / 2);
 
         // Keep the popup on the current monitor.
         HWND esWnd = GetForegroundWindow();
@@ -910,6 +1028,11 @@ namespace {
         g_handoffHoverIndex = anchorRow;
         g_handoffHoverSubIndex = -1;  // no sub-button pre-highlighted
 
+        // New rows: the back buffer is rendered once by the paint below
+        EnsurePopupBackBuffer(g_handoffPopupWnd, g_popupStyle.popupWidth,
+            (std::max)(height, GetMaxCustomHandoffPopupHeight()));
+        g_backDirty = true;
+
         SetWindowPos(
             g_handoffPopupWnd,
             HWND_TOPMOST,
@@ -919,17 +1042,66 @@ namespace {
             height,
             SWP_NOACTIVATE | SWP_SHOWWINDOW);
 
-        InvalidateRect(g_handoffPopupWnd, NULL, TRUE);
+        InvalidateRect(g_handoffPopupWnd, NULL, FALSE);
         UpdateWindow(g_handoffPopupWnd);
     }
 }
 
 
-std::vector<LOAEntry> destinationLoas;
-std::vector<LOAEntry> departureLoas;
-std::vector<LOAEntry> destinationFallbackLoas;
-std::vector<LOAEntry> departureFallbackLoas;
+std::vector<const LoaHotEntry*> destinationLoas;
+std::vector<const LoaHotEntry*> departureLoas;
+std::vector<const LoaHotEntry*> destinationFallbackLoas;
+std::vector<const LoaHotEntry*> departureFallbackLoas;
 std::map<std::string, std::vector<LOAEntry>> loadedSectorLoas;
+std::map<std::string, std::vector<LoaHotEntry>> loadedSectorLoaHot;
+MonotonicArena loadedLoaArena;
+
+// Tables of the previous position: thousands of strings, vectors and hash nodes, plus
+// their hot arrays. Nothing points into them any more once the reload has reset the
+// lists, indexes and flight matches, so they are queued for the retire worker instead of
+// being freed on the EuroScope thread (the arena goes with them in one shot).
+void LOAPlugin::RetireLoaTables()
+{
+    if (loadedSectorLoas.empty()) {
+        loadedSectorLoaHot.clear(); // at most empty per-sector arrays
+        return;
+    }
+
+    std::unique_ptr<RetiredLoaTables> retired(new RetiredLoaTables());
+    retired->tables.swap(loadedSectorLoas);
+    retired->hot.swap(loadedSectorLoaHot);
+    retired->arena = std::move(loadedLoaArena);
+
+    if (!retireWorker.joinable()) {
+        try {
+            retireWorker = std::thread([this]() { RetireLoop(); });
+        }
+        catch (...) {
+            return; // no worker: 'retired' is freed here, as before
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(retireLock);
+        retireQueue.push_back(std::move(retired));
+    }
+    retireWake.notify_one();
+}
+
+void LOAPlugin::RetireLoop()
+{
+    std::unique_lock<std::mutex> lock(retireLock);
+    for (;;) {
+        retireWake.wait(lock, [this]() { return retireStop || !retireQueue.empty(); });
+        if (retireQueue.empty()) return; // stopping, and everything queued is freed
+
+        std::unique_ptr<RetiredLoaTables> retired = std::move(retireQueue.front());
+        retireQueue.pop_front();
+        lock.unlock();
+        retired.reset();
+        lock.lock();
+    }
+}
 
 std::string NormalizeRunway(const std::string& in)
 {
@@ -941,9 +1113,13 @@ int nextFunctionId = 1000;
 LOAPlugin::LOAPlugin()
     : CPlugIn(COMPATIBILITY_CODE, "LOA Plugin", "1.1", "Author", "LOA Plugin")
 {
-    startTick = GetTickCount64();
-    coldStartUntil = startTick + 5000;   // 5s warm-up window
-    coldStartActive = true;
+    // Per-refresh compute budget (persisted by ".loa budget <ms>")
+    if (const char* budget = GetDataFromSettings("RefreshBudgetMs")) {
+        if (budget[0] && !ParseRefreshBudgetMs(budget, refreshBudgetMs)) {
+            DisplayUserMessage("LOA Plugin", "Budget", "Ignoring invalid RefreshBudgetMs setting; using the default",
+                true, true, false, false, false);
+        }
+    }
 
     static bool registered = false;
     if (!registered) {
@@ -958,74 +1134,39 @@ LOAPlugin::LOAPlugin()
     LoadSectorOwnership();
 
     // Load optional custom volumes (volumes.json) from the same folder as sector_ownership.json
-    {
-        char dllPath[MAX_PATH];
-        GetModuleFileNameA(HINSTANCE(&__ImageBase), dllPath, sizeof(dllPath));
-        std::string basePath(dllPath);
-        size_t lastSlash = basePath.find_last_of("\\/");
-        basePath = (lastSlash != std::string::npos) ? basePath.substr(0, lastSlash) : ".";
-        std::string volumesPath = basePath + "\\loa_configs_json\\volumes.json";
-        LoadVolumesFromJSON(volumesPath);
-    }
+    LoadVolumesFromJSON(PluginFolder() + "\\loa_configs_json\\volumes.json");
 
     std::string sector = ControllerMyself().GetPositionId();
     if (!sector.empty()) {
         LoadLOAsFromJSON();
 
-        // Prime controller snapshot early; helps avoid a cold-start thrash
+        // Prime controller snapshot early; the first refreshes are spread by the compute budget
         currentFrameOnlineControllers = GetOnlineControllersCached();
-        if (GetTickCount64() >= coldStartUntil) {
-            coldStartActive = false;
-        }
     }
 
     // Prime active runway caches once at startup (and whenever ES notifies changes)
     UpdateActiveRunwaysFromSectorFile();
 }
 
-bool LOAPlugin::IsPointInsidePolygon(const CPosition& p,
-    const std::vector<CPosition>& poly) const
-{
-    const size_t n = poly.size();
-    if (n < 3) return false;
-
-    bool inside = false;
-    const double x = p.m_Longitude;
-    const double y = p.m_Latitude;
-
-    for (size_t i = 0, j = n - 1; i < n; j = i++) {
-        const double xi = poly[i].m_Longitude;
-        const double yi = poly[i].m_Latitude;
-        const double xj = poly[j].m_Longitude;
-        const double yj = poly[j].m_Latitude;
-
-        const bool intersect =
-            ((yi > y) != (yj > y)) &&
-            (x < (xj - xi) * (y - yi) / ((yj - yi) + 1e-9) + xi);
-
-        if (intersect)
-            inside = !inside;
-    }
-    return inside;
-}
-
 void LOAPlugin::OnControllerPositionUpdate(EuroScopePlugIn::CController controller)
 {
+    const char* controllerCallsign = controller.GetCallsign();
+    UpdateControllerContact(controller);
+    TrackControllerStation(controllerCallsign ? controllerCallsign : "", controller.GetPositionId());
+    CheckForOwnershipChange(); // no-op unless the online set changed
+
+    // Everything below is about my own position; other controllers only move the online set
+    const char* myCallsign = ControllerMyself().GetCallsign();
+    if (!controllerCallsign || !myCallsign || _stricmp(controllerCallsign, myCallsign) != 0)
+        return;
+
     // Reload LOAs when my controller position changes, but FIRST invalidate caches holding LOAEntry*
     std::string sector = controller.GetPositionId();
     if (!sector.empty() && sector != this->loadedSector) {
         // Invalidate everything that can hold dangling LOAEntry* pointers
         sectorControlVersion++;
-        matchedLOACache.clear();
-        matchTimestamps.clear();
-        matchVersions.clear();
-        routeCache.clear();
-        routeSetCache.clear();
-        coordinationStates.clear();
-        routeCacheTime.clear();
-        routeSetCacheTime.clear();
-
-        currentFrameMatchedEntry = nullptr;
+        ResetFlightStates(FS_RESET_MATCH | FS_RESET_ROUTE | FS_RESET_COORDINATION);
+
         indexByWaypoint.clear();
         indexByNextSector.clear();
 
@@ -1035,10 +1176,6 @@ void LOAPlugin::OnControllerPositionUpdate(EuroScopePlugIn::CController controll
         // 🔄 Immediately refresh online-controllers snapshot for the new sector
         currentFrameOnlineControllers = GetOnlineControllersCached();
 
-        // 🚫 Disable cold-start delay after a manual sector switch
-        coldStartActive = false;
-        coldStartUntil = 0;
-
         // Proactively clean per-flight caches (forces re-render paths)
         for (EuroScopePlugIn::CFlightPlan fp = FlightPlanSelectFirst(); fp.IsValid(); fp = FlightPlanSelectNext(fp)) {
             CleanupCache(fp.GetCallsign());
@@ -1048,20 +1185,35 @@ void LOAPlugin::OnControllerPositionUpdate(EuroScopePlugIn::CController controll
     }
 }
 
-LOAPlugin::~LOAPlugin() {
+void LOAPlugin::Shutdown()
+{
+    // EuroScope unloads the DLL right after EuroScopePlugInExit; no worker may still be
+    // running its code. Called from there, outside the loader lock, so joining is safe.
+    if (volumeReloadWorker.joinable()) volumeReloadWorker.join();
+    if (retireWorker.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(retireLock);
+            retireStop = true;
+        }
+        retireWake.notify_one();
+        retireWorker.join();
+    }
+    loaTracer.Stop();
     DestroyCustomHandoffPopup();
 }
 
+LOAPlugin::~LOAPlugin() {
+    // Without Shutdown() (process exit) a joinable std::thread would terminate, and a
+    // join under the loader lock could deadlock
+    if (volumeReloadWorker.joinable()) volumeReloadWorker.detach();
+    if (retireWorker.joinable()) retireWorker.detach();
+}
+
 
 void LOAPlugin::LoadSectorOwnership()
 {
-    char dllPath[MAX_PATH];
-    GetModuleFileNameA(HINSTANCE(&__ImageBase), dllPath, sizeof(dllPath));
-    std::string basePath(dllPath);
-    size_t lastSlash = basePath.find_last_of("\\/");
-    basePath = (lastSlash != std::string::npos) ? basePath.substr(0, lastSlash) : ".";
-
-    std::string filePath = basePath + "\\loa_configs_json\\sector_ownership.json";
+    LOA_TRACE_SCOPE("load", "LoadSectorOwnership");
+    std::string filePath = PluginFolder() + "\\loa_configs_json\\sector_ownership.json";
     std::ifstream in(filePath);
     if (!in.is_open()) {
         DisplayUserMessage("LOA Plugin", "Sector Ownership", "Failed to open sector_ownership.json", true, true, false, false, false);
@@ -1091,6 +1243,41 @@ void LOAPlugin::LoadSectorOwnership()
         }
     }
 
+    // Optional: sector-file elements to index for route-based next sectors, e.g.
+    // "sectorPolygons": { "EDWW ALR": { "sector": "ALR", "lowerFL": 0, "upperFL": 245 } }
+    sectorPolygonSources.clear();
+    if (j.contains("sectorPolygons") && j["sectorPolygons"].is_object()) {
+        for (json::iterator it = j["sectorPolygons"].begin(); it != j["sectorPolygons"].end(); ++it) {
+            const json& v = it.value();
+            if (!v.is_object() || !v.contains("sector") || !v["sector"].is_string()) continue;
+
+            SectorPolygonSource src;
+            src.sectorId = v["sector"].get<std::string>();
+
+            // Both limits are required; an element without them is left to EuroScope
+            if (v.contains("lowerFt") && v["lowerFt"].is_number() && v.contains("upperFt") && v["upperFt"].is_number()) {
+                src.lowerFt = v["lowerFt"].get<double>();
+                src.upperFt = v["upperFt"].get<double>();
+            }
+            else if (v.contains("lowerFL") && v["lowerFL"].is_number_integer() && v.contains("upperFL") && v["upperFL"].is_number_integer()) {
+                src.lowerFt = (double)v["lowerFL"].get<int>() * 100.0;
+                src.upperFt = (double)v["upperFL"].get<int>() * 100.0;
+            }
+            else {
+                continue;
+            }
+            if (src.sectorId.empty() || src.upperFt <= src.lowerFt) continue;
+
+            sectorPolygonSources[LoaNameKey(it.key())] = std::move(src);
+        }
+    }
+
+    sectorGraph.Build(sectorOwnership, sectorPriority);
+    RebuildSectorGraphState();
+
+    // Sector-file polygons are keyed by the IDs above
+    sectorPolygonsDirty = true;
+
     DisplayUserMessage("LOA Plugin", "Sector Ownership", "sector_ownership.json loaded successfully", true, true, false, false, false);
 }
 
@@ -1171,27 +1358,19 @@ static bool TryReadVolumePointLL(const json& pt, double& outLat, double& outLon)
 
     return false;
 }
-// Load custom volumes from a separate JSON file (optional).
-// Path is usually: <plugin folder>\loa_configs_json\volumes.json
-void LOAPlugin::LoadVolumesFromJSON(const std::string& volumesPath)
+// Parse volumes.json and build a complete, immutable-once-published volume set.
+// Touches no plugin or EuroScope state, so it can run on the reload worker thread;
+// user-facing messages are collected and shown by the caller on the UI thread.
+// 'proj' is anchored at the centroid of all vertices only if it is not valid yet.
+static bool BuildCustomVolumeSet(const std::string& volumesPath, PlanarProjection& proj,
+    CustomVolumeSet& out, std::vector<std::string>& messages)
 {
-    // Load volumes only once per plugin session. Volumes are global/static configuration and
-    // reloading them during sector switches is redundant and can be crash-prone due to
-    // EuroScope callback re-entrancy.
-    if (volumesLoadAttempted) {
-        return;
-    }
-    volumesLoadAttempted = true;
-    volumesLoadedPath = volumesPath;
-
-    customVolumes.clear();
+    out.Clear();
 
     std::ifstream f(volumesPath.c_str(), std::ios::in);
     if (!f.good()) {
-        std::string msg = std::string("volumes.json NOT found (optional): ") + volumesPath;
-        DisplayUserMessage("LOA Plugin", "Volumes", msg.c_str(), true, true, false, false, false);
-        volumesLoadedOk = false;
-        return;
+        messages.push_back(std::string("volumes.json NOT found (optional): ") + volumesPath);
+        return false;
     }
 
     json j;
@@ -1199,19 +1378,22 @@ void LOAPlugin::LoadVolumesFromJSON(const std::string& volumesPath)
         f >> j;
     }
     catch (...) {
-        std::string msg = std::string("Failed to parse volumes.json: ") + volumesPath;
-        DisplayUserMessage("LOA Plugin", "Volumes", msg.c_str(), true, true, false, false, false);
-        volumesLoadedOk = false;
-        return;
+        messages.push_back(std::string("Failed to parse volumes.json: ") + volumesPath);
+        return false;
     }
 
     if (!j.is_object() || !j.contains("volumes") || !j["volumes"].is_array()) {
-        std::string msg = std::string("volumes.json missing 'volumes' array: ") + volumesPath;
-        DisplayUserMessage("LOA Plugin", "Volumes", msg.c_str(), true, true, false, false, false);
-        volumesLoadedOk = false;
-        return;
+        messages.push_back(std::string("volumes.json missing 'volumes' array: ") + volumesPath);
+        return false;
     }
 
+    // Parse everything first: the projection anchor is the centroid of all vertices,
+    // so polygons can only be projected once the whole file has been read.
+    std::vector<std::pair<CustomVolume, std::vector<std::pair<double, double>>>> parsed;
+    double latSum = 0.0;
+    double lonSum = 0.0;
+    size_t pointCount = 0;
+
     for (const auto& v : j["volumes"]) {
         if (!v.is_object()) continue;
         if (!v.contains("id") || !v["id"].is_string()) continue;
@@ -1233,16 +1415,14 @@ void LOAPlugin::LoadVolumesFromJSON(const std::string& volumesPath)
             cv.upperFt = (double)hiFL * 100.0;
         }
 
-        cv.polygon.clear();
+        std::vector<std::pair<double, double>> polygonLL;
         int skippedPoints = 0;
         if (v.contains("polygon") && v["polygon"].is_array()) {
             for (const auto& pt : v["polygon"]) {
                 double lat = 0.0;
                 double lon = 0.0;
                 if (TryReadVolumePointLL(pt, lat, lon)) {
-                    // Store internally as decimal degrees. The predicted route logic already uses
-                    // decimal lat/lon, so no changes are needed in the matcher.
-                    cv.polygon.push_back(std::make_pair(lat, lon));
+                    polygonLL.push_back(std::make_pair(lat, lon));
                 }
                 else {
                     ++skippedPoints;
@@ -1253,52 +1433,336 @@ void LOAPlugin::LoadVolumesFromJSON(const std::string& volumesPath)
         if (skippedPoints > 0) {
             char warn[256];
             sprintf_s(warn, sizeof(warn), "Volume %s skipped %d invalid coordinate point(s)", cv.id.c_str(), skippedPoints);
-            DisplayUserMessage("LOA Plugin", "Volumes", warn, true, true, false, false, false);
+            messages.push_back(warn);
+        }
+
+        if (polygonLL.size() >= 3) {
+            for (const auto& ll : polygonLL) {
+                latSum += ll.first;
+                lonSum += ll.second;
+            }
+            pointCount += polygonLL.size();
+            parsed.push_back(std::make_pair(std::move(cv), std::move(polygonLL)));
+        }
+    }
+
+    if (pointCount > 0 && !proj.valid) {
+        proj.SetAnchor(latSum / (double)pointCount, lonSum / (double)pointCount);
+    }
+
+    for (auto& entry : parsed) {
+        CustomVolume& cv = entry.first;
+        cv.polygon.reserve(entry.second.size());
+        for (const auto& ll : entry.second) {
+            const PlanarPoint p = proj.Project(ll.first, ll.second);
+            if (cv.polygon.empty()) {
+                cv.boundsMin = p;
+                cv.boundsMax = p;
+            }
+            else {
+                if (p.x < cv.boundsMin.x) cv.boundsMin.x = p.x;
+                if (p.y < cv.boundsMin.y) cv.boundsMin.y = p.y;
+                if (p.x > cv.boundsMax.x) cv.boundsMax.x = p.x;
+                if (p.y > cv.boundsMax.y) cv.boundsMax.y = p.y;
+            }
+            cv.polygon.push_back(p);
+        }
+        // Duplicate IDs: the last definition wins
+        auto idxIt = out.indexById.find(cv.id);
+        if (idxIt != out.indexById.end()) {
+            out.volumes[idxIt->second] = std::move(cv);
+        }
+        else {
+            out.indexById.emplace(cv.id, (uint32_t)out.volumes.size());
+            out.volumes.push_back(std::move(cv));
         }
+    }
 
-        if (cv.polygon.size() >= 3) {
-            customVolumes[cv.id] = cv;
+    {
+        std::vector<double> lower;
+        std::vector<double> upper;
+        lower.reserve(out.volumes.size());
+        upper.reserve(out.volumes.size());
+        for (const CustomVolume& cv : out.volumes) {
+            lower.push_back(cv.lowerFt);
+            upper.push_back(cv.upperFt);
         }
+        out.bands.Build(lower, upper);
     }
 
     char buf[256];
-    sprintf_s(buf, sizeof(buf), "volumes.json loaded successfully (%d volumes)", (int)customVolumes.size());
-    std::string msg = std::string(buf) + ": " + volumesPath;
-    DisplayUserMessage("LOA Plugin", "Volumes", msg.c_str(), true, true, false, false, false);
+    sprintf_s(buf, sizeof(buf), "volumes.json loaded successfully (%d volumes)", (int)out.volumes.size());
+    messages.push_back(std::string(buf) + ": " + volumesPath);
+    return true;
+}
 
-    volumesLoadedOk = true;
+static bool ReadFileWriteStamp(const std::string& path, unsigned long long& outStamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) return false;
+    // Write time and size together: editors that keep the timestamp still change the size
+    outStamp = ((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) ^
+        (unsigned long long)data.ftLastWriteTime.dwLowDateTime ^
+        ((unsigned long long)data.nFileSizeLow * 1099511628211ULL);
+    return true;
+}
+
+// Load custom volumes from a separate JSON file (optional).
+// Path is usually: <plugin folder>\loa_configs_json\volumes.json
+void LOAPlugin::LoadVolumesFromJSON(const std::string& volumesPath)
+{
+    // Initial load runs once per session on the UI thread and fixes the projection anchor.
+    // Later changes go through RequestVolumesReload (worker thread + snapshot swap), never
+    // through sector switches.
+    if (volumesLoadAttempted) {
+        return;
+    }
+    volumesLoadAttempted = true;
+    volumesLoadedPath = volumesPath;
+    LOA_TRACE_SCOPE("load", "LoadVolumesFromJSON");
+    ReadFileWriteStamp(volumesPath, volumesFileStamp);
+
+    std::shared_ptr<CustomVolumeSet> next = std::make_shared<CustomVolumeSet>();
+    std::vector<std::string> messages;
+    volumesLoadedOk = BuildCustomVolumeSet(volumesPath, planarProjection, *next, messages);
+    next->generation = ++volumeGenerationCounter;
+
+    for (const std::string& msg : messages) {
+        DisplayUserMessage("LOA Plugin", "Volumes", msg.c_str(), true, true, false, false, false);
+    }
+
+    if (volumesLoadedOk) {
+        std::atomic_store(&customVolumes, CustomVolumeSnapshot(std::move(next)));
+    }
+}
+
+bool LOAPlugin::RequestVolumesReload()
+{
+    if (volumesLoadedPath.empty()) return false;
+    if (volumeReloadPending) return false; // one reload at a time; the poll catches later edits
+
+    ReadFileWriteStamp(volumesLoadedPath, volumesFileStamp);
+
+    std::shared_ptr<VolumeReloadResult> result = std::make_shared<VolumeReloadResult>();
+    result->projection = planarProjection;
+    volumeReloadPending = result;
+
+    const std::string path = volumesLoadedPath;
+    const uint32_t generation = ++volumeGenerationCounter;
+
+    // Only one reload is pending at a time, so the previous worker has already handed
+    // over its result and this join returns at once.
+    if (volumeReloadWorker.joinable()) volumeReloadWorker.join();
+
+    // The worker owns only 'result'; it never touches the plugin or EuroScope. The UI
+    // thread picks the result up in OnTimer; Shutdown() joins it before unload.
+    try {
+        volumeReloadWorker = std::thread([result, path, generation]() {
+            LOA_TRACE_SCOPE("load", "ReloadVolumes");
+            std::shared_ptr<CustomVolumeSet> next = std::make_shared<CustomVolumeSet>();
+            std::vector<std::string> messages;
+            PlanarProjection proj = result->projection;
+            const bool ok = BuildCustomVolumeSet(path, proj, *next, messages);
+            next->generation = generation;
+
+            std::lock_guard<std::mutex> guard(result->lock);
+            if (ok) result->snapshot = std::move(next);
+            result->projection = proj;
+            result->messages.swap(messages);
+            result->ready = true;
+            });
+    }
+    catch (...) {
+        volumeReloadPending.reset();
+        DisplayUserMessage("LOA Plugin", "Volumes", "Failed to start volumes.json reload", true, true, false, false, false);
+        return false;
+    }
+    return true;
+}
+
+void LOAPlugin::PublishVolumesReloadIfReady()
+{
+    if (!volumeReloadPending) return;
+
+    CustomVolumeSnapshot snapshot;
+    PlanarProjection proj;
+    std::vector<std::string> messages;
+    {
+        std::lock_guard<std::mutex> guard(volumeReloadPending->lock);
+        if (!volumeReloadPending->ready) return;
+        snapshot = volumeReloadPending->snapshot;
+        proj = volumeReloadPending->projection;
+        messages.swap(volumeReloadPending->messages);
+    }
+    volumeReloadPending.reset();
+
+    for (const std::string& msg : messages) {
+        DisplayUserMessage("LOA Plugin", "Volumes", msg.c_str(), true, true, false, false, false);
+    }
+    if (!snapshot) return; // keep the previous volumes on any load error
+
+    // The plane is fixed for the session once anchored (sector polygons share it)
+    if (!planarProjection.valid) {
+        planarProjection = proj;
+        sectorPolygonsDirty = true;
+    }
+    else if (proj.anchorLat != planarProjection.anchorLat || proj.anchorLon != planarProjection.anchorLon) {
+        RequestVolumesReload();
+        return;
+    }
+
+    // One swap; matches still holding the old snapshot finish on it. Cached matches
+    // notice the new generation and recompute lazily.
+    std::atomic_store(&customVolumes, snapshot);
+    volumesLoadedOk = true;
+    LOA_TRACE_INSTANT("load", "VolumesPublished", nullptr);
+}
+
+void LOAPlugin::PollVolumesFileIfNeeded()
+{
+    const ULONGLONG nowMs = GetTickCount64();
+    if (nowMs - lastVolumesPollMs < 5000ULL) return;
+    lastVolumesPollMs = nowMs;
+
+    if (volumesLoadedPath.empty() || volumeReloadPending) return;
+
+    unsigned long long stamp = 0;
+    if (!ReadFileWriteStamp(volumesLoadedPath, stamp)) return;
+    if (stamp != volumesFileStamp) {
+        RequestVolumesReload();
+    }
+}
+
+void LOAPlugin::OnTimer(int Counter)
+{
+    if (!popupPrewarmed) {
+        popupPrewarmed = true;
+        PrewarmCustomHandoffPopup();
+    }
+
+    PublishVolumesReloadIfReady();
+    PollVolumesFileIfNeeded();
+    RefreshVisibleFlights(GetTickCount64());
+    LoaTraceCacheCounters();
+}
+
+bool LOAPlugin::OnCompileCommand(const char* sCommandLine)
+{
+    if (!sCommandLine) return false;
+
+    std::string cmd(sCommandLine);
+    std::transform(cmd.begin(), cmd.end(), cmd.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    while (!cmd.empty() && (cmd.back() == ' ' || cmd.back() == '\t')) cmd.pop_back();
+
+    if (cmd == ".loa reload volumes") {
+        if (RequestVolumesReload()) {
+            DisplayUserMessage("LOA Plugin", "Volumes", "Reloading volumes.json...", true, true, false, false, false);
+        }
+        else {
+            DisplayUserMessage("LOA Plugin", "Volumes", "volumes.json reload already running or no path known", true, true, false, false, false);
+        }
+        return true;
+    }
+
+    if (cmd == ".loa budget" || cmd.compare(0, 12, ".loa budget ") == 0) {
+        if (cmd.size() > 12) {
+            int ms = 0;
+            if (!ParseRefreshBudgetMs(cmd.c_str() + 12, ms)) {
+                DisplayUserMessage("LOA Plugin", "Budget", "Usage: .loa budget <0-1000> (ms, 0 = unlimited)",
+                    true, true, false, false, false);
+                return true;
+            }
+            SetRefreshBudget(ms);
+        }
+        char buf[128];
+        sprintf_s(buf, sizeof(buf), "Refresh budget: %d ms (0 = unlimited), deferred last refresh: %d",
+            refreshBudgetMs, lastRefreshDeferred);
+        DisplayUserMessage("LOA Plugin", "Budget", buf, true, true, false, false, false);
+        return true;
+    }
+
+    if (cmd == ".loa gates" || cmd == ".loa gates reset" ||
+        cmd == ".loa gates verify on" || cmd == ".loa gates verify off") {
+        if (cmd == ".loa gates reset") loaGates.Reset();
+        else if (cmd == ".loa gates verify on") loaGates.verify = true;
+        else if (cmd == ".loa gates verify off") loaGates.verify = false;
+        ReportLoaGates();
+        return true;
+    }
+
+    if (cmd == ".loa stats" || cmd == ".loa stats reset") {
+        if (cmd == ".loa stats reset") {
+            loaStats.Reset();
+            DisplayUserMessage("LOA Plugin", "Stats", "Statistics reset", true, true, false, false, false);
+        }
+        else {
+            ReportLoaStats();
+        }
+        return true;
+    }
+
+    if (cmd == ".loa stats caches") {
+        ReportLoaCacheStats();
+        return true;
+    }
+
+    if (cmd == ".loa stats dump") {
+        const std::string path = PluginFolder() + "\\loa_stats.csv";
+        const bool ok = DumpLoaStats(path);
+        DisplayUserMessage("LOA Plugin", "Stats", ((ok ? "Statistics written to " : "Failed to write ") + path).c_str(),
+            true, true, false, false, false);
+        return true;
+    }
+
+    if (cmd == ".loa trace on" || cmd == ".loa trace off" || cmd == ".loa trace") {
+        char buf[MAX_PATH + 64];
+        if (cmd == ".loa trace on") {
+            const std::string path = PluginFolder() + "\\loa_trace.json";
+            if (loaTracer.Enabled() || loaTracer.Start(path))
+                sprintf_s(buf, sizeof(buf), "Tracing to %s", loaTracer.Path().c_str());
+            else
+                sprintf_s(buf, sizeof(buf), "Failed to start tracing to %s", path.c_str());
+        }
+        else if (cmd == ".loa trace off") {
+            const bool wasOn = loaTracer.Enabled();
+            loaTracer.Stop();
+            if (wasOn)
+                sprintf_s(buf, sizeof(buf), "Trace written to %s (%llu events dropped)",
+                    loaTracer.Path().c_str(), (unsigned long long)loaTracer.Dropped());
+            else
+                sprintf_s(buf, sizeof(buf), "Tracing is off");
+        }
+        else {
+            sprintf_s(buf, sizeof(buf), "Tracing is %s", loaTracer.Enabled() ? "on" : "off");
+        }
+        DisplayUserMessage("LOA Plugin", "Trace", buf, true, true, false, false, false);
+        return true;
+    }
+
+    if (cmd == ".loa mem") {
+        ReportMemory();
+        return true;
+    }
+
+    return false;
 }
 
 
 void LOAPlugin::LoadLOAsFromJSON() {
     std::string mySector = ControllerMyself().GetPositionId();
     if (mySector.empty() || mySector == this->loadedSector) return;
+    LOA_STATS_SCOPE(LOA_STAT_LOAD_LOAS);
+    LOA_TRACE_SCOPE_ARG("load", "LoadLOAsFromJSON", mySector.c_str());
 
     // Hard invalidate before reload (kept from prior patch)
     this->loadedSector = mySector;
     ++sectorControlVersion;
-    currentFrameMatchedEntry = nullptr;
-    currentFrameCallsign.clear();
-    matchedLOACache.clear();
-    matchTimestamps.clear();
-    matchVersions.clear();
-    routeCache.clear();
-    routeCacheTime.clear();
-    routeSignature.clear();
-    coordinationStates.clear();
-    currentFrameRoutePoints.clear();
-    currentFrameRouteSet.clear();
+    ResetFlightStates(FS_RESET_MATCH | FS_RESET_ROUTE | FS_RESET_ROUTE_SIGNATURE |
+        FS_RESET_COORDINATION | FS_RESET_RENDER);
     currentFrameOnlineControllers.clear();
     lastOnlineFetchTime = 0;
-    renderCache.clear();
-
-    char dllPath[MAX_PATH];
-    GetModuleFileNameA(HINSTANCE(&__ImageBase), dllPath, sizeof(dllPath));
 
-    std::string basePath(dllPath);
-    size_t lastSlash = basePath.find_last_of("\\/");
-    basePath = (lastSlash != std::string::npos) ? basePath.substr(0, lastSlash) : ".";
-    std::string baseFolder = basePath + "\\loa_configs_json\\";
+    std::string baseFolder = PluginFolder() + "\\loa_configs_json\\";
     // volumes.json is loaded once at plugin startup; do NOT reload here.
     std::string filePath = baseFolder + "LOA.json";
 
@@ -1319,6 +1783,15 @@ void LOAPlugin::LoadLOAsFromJSON() {
     destinationFallbackLoas.clear();
     departureFallbackLoas.clear();
     validLoaEntryPtrs.clear();
+    indexByWaypoint.clear();
+    indexByNextSector.clear();
+
+    // Per-sector tables are rebuilt from scratch for a new position
+    RetireLoaTables();
+    loadedSectorOrder.clear();
+    activeLoaSectors.clear();
+    sectorBitIds.clear();
+    trackedSectorControl.clear();
 
     aorDestinationSet.clear();
     aorDestinationPrefixes.clear();
@@ -1420,6 +1893,11 @@ void LOAPlugin::LoadLOAsFromJSON() {
             else if (item.contains("runways")) {
                 loa.runways = readRunways(item["runways"]);
             }
+            for (const auto& r : loa.runways) {
+                // Designators beyond the mask width stay unset and never match
+                const uint16_t id = runwayTable.InternRunway(r.c_str());
+                if (id != RunwayTable::kNone) loa.runwayMask.Set(id);
+            }
 
             if (item.contains("waypoints"))
                 loa.waypoints = item["waypoints"].get<std::vector<std::string>>();
@@ -1510,24 +1988,24 @@ void LOAPlugin::LoadLOAsFromJSON() {
 
     for (const std::string& sector : sectorsToLoadOrdered) {
         if (!config.contains(sector)) continue;
+        if (loadedSectorLoas.count(sector)) continue;
         const json& sectorConfig = config[sector];
 
-        if (sectorConfig.contains("destinationLoas")) {
-            auto list = parseLOAList(sectorConfig["destinationLoas"], sector, LOAListKind::Destination);
-            destinationLoas.insert(destinationLoas.end(), list.begin(), list.end());
-        }
-        if (sectorConfig.contains("departureLoas")) {
-            auto list = parseLOAList(sectorConfig["departureLoas"], sector, LOAListKind::Departure);
-            departureLoas.insert(departureLoas.end(), list.begin(), list.end());
-        }
-        if (sectorConfig.contains("destinationFallbackLoas")) {
-            auto list = parseLOAList(sectorConfig["destinationFallbackLoas"], sector, LOAListKind::DestinationFallback);
-            destinationFallbackLoas.insert(destinationFallbackLoas.end(), list.begin(), list.end());
-        }
-        if (sectorConfig.contains("departureFallbackLoas")) {
-            auto list = parseLOAList(sectorConfig["departureFallbackLoas"], sector, LOAListKind::DepartureFallback);
-            departureFallbackLoas.insert(departureFallbackLoas.end(), list.begin(), list.end());
-        }
+        // All list kinds of one source sector share one table; entries never move after load
+        std::vector<LOAEntry>& table = loadedSectorLoas[sector];
+        loadedSectorOrder.push_back(sector);
+
+        auto appendList = [&](const char* key, LOAListKind kind) {
+            if (!sectorConfig.contains(key)) return;
+            auto list = parseLOAList(sectorConfig[key], sector, kind);
+            table.insert(table.end(),
+                std::make_move_iterator(list.begin()), std::make_move_iterator(list.end()));
+            };
+        appendList("destinationLoas", LOAListKind::Destination);
+        appendList("departureLoas", LOAListKind::Departure);
+        appendList("destinationFallbackLoas", LOAListKind::DestinationFallback);
+        appendList("departureFallbackLoas", LOAListKind::DepartureFallback);
+
         if (sectorConfig.contains("aorDestinations")) {
             auto aorList = sectorConfig["aorDestinations"].get<std::vector<std::string>>();
             processAirportList(aorList, aorDestinationSet, aorDestinationPrefixes);
@@ -1536,111 +2014,218 @@ void LOAPlugin::LoadLOAsFromJSON() {
 
     }
 
-    // Rebuild indices (only over the two active lists)
-    indexByWaypoint.clear();
-    indexByNextSector.clear();
-
-    auto indexEntries = [&](const std::vector<LOAEntry>& entries) {
-        for (const LOAEntry& entry : entries) {
-            const LOAEntry* ptr = &entry;
-            for (const std::string& wp : entry.waypoints) {
-                indexByWaypoint[wp].push_back(ptr);
-            }
+    // Dense IDs for the per-flight dependency masks: source sectors first, then next sectors
+    for (const std::string& sector : loadedSectorOrder) {
+        sectorBitIds.emplace(sector, (uint32_t)sectorBitIds.size());
+    }
+    for (const std::string& sector : loadedSectorOrder) {
+        for (const LOAEntry& entry : loadedSectorLoas[sector]) {
+            for (const std::string& next : entry.nextSectors) {
+                sectorBitIds.emplace(next, (uint32_t)sectorBitIds.size());
+            }
+        }
+    }
+    // Hot arrays parallel to the tables; sized once, so pointers into them stay valid
+    std::vector<uint16_t> ids;
+    for (const auto& kv : loadedSectorLoas) {
+        std::vector<LoaHotEntry>& hotTable = loadedSectorLoaHot[kv.first];
+        hotTable.resize(kv.second.size());
+        for (size_t i = 0; i < kv.second.size(); ++i) {
+            const LOAEntry& entry = kv.second[i];
+            LoaHotEntry& hot = hotTable[i];
+            hot.entry = &entry;
+
+            ids.clear();
+            for (const std::string& src : entry.sectors) ids.push_back(sectorGraph.Id(src));
+            hot.sectorIds.ids = loadedLoaArena.Copy(ids.data(), ids.size());
+            hot.sectorIds.count = (uint32_t)ids.size();
+            ids.clear();
+            for (const std::string& next : entry.nextSectors) ids.push_back(sectorGraph.Id(next));
+            hot.nextSectorIds.ids = loadedLoaArena.Copy(ids.data(), ids.size());
+            hot.nextSectorIds.count = (uint32_t)ids.size();
+
+            hot.sectorMask = SectorMaskBit(kv.first);
             for (const std::string& next : entry.nextSectors) {
-                indexByNextSector[next].push_back(ptr);
+                hot.sectorMask |= SectorMaskBit(next);
             }
-        }
-        };
-
-    indexEntries(destinationLoas);
-    indexEntries(departureLoas);
 
-    // Rebuild O(1) pointer-validity set now that all entry vectors are final
-    validLoaEntryPtrs.clear();
-    for (const auto& e : destinationLoas)         validLoaEntryPtrs.insert(&e);
-    for (const auto& e : departureLoas)           validLoaEntryPtrs.insert(&e);
-    for (const auto& e : destinationFallbackLoas) validLoaEntryPtrs.insert(&e);
-    for (const auto& e : departureFallbackLoas)   validLoaEntryPtrs.insert(&e);
+            hot.staticScore = LoaStaticScore(entry);
+            hot.xfl = entry.xfl;
+            hot.constraintFlags = LoaConstraintFlagsOf(entry);
+            hot.listKind = entry.listKind;
+            hot.runwayMask = entry.runwayMask;
+        }
+    }
 
+    // Baseline for CheckForOwnershipChange, then activate every source sector I am not outranked in
     currentFrameOnlineControllers = GetOnlineControllersCached();
-    if (GetTickCount64() >= coldStartUntil) {
-        coldStartActive = false;
+    ownershipCheckVersion = onlineControllersVersion;
+    for (const auto& kv : sectorBitIds) {
+        trackedSectorControl[kv.first] = ResolveControllingSector(kv.first);
+    }
+    for (const std::string& sector : loadedSectorOrder) {
+        if (!IsSectorOutranked(sector, mySector)) SetLoaSectorActive(sector, true);
     }
+    RebuildActiveLoaLists();
 
     DisplayUserMessage("LOA Plugin", "LOA Load", ("LOAs loaded for: " + mySector).c_str(), true, true, true, true, false);
 }
 
-// ---------------- Active Airports/Runways (sector file) ----------------
+// ---------------- Per-sector LOA tables ----------------
 
-
-void LOAPlugin::OnAirportRunwayActivityChanged(void)
+uint64_t LOAPlugin::SectorMaskBit(const std::string& sector) const
 {
-    // Some EuroScope builds fire this reliably, some don't. If it fires, refresh immediately.
-    UpdateActiveRunwaysFromSectorFile();
+    auto it = sectorBitIds.find(sector);
+    if (it == sectorBitIds.end()) return 0;
+    // Beyond 64 sectors bits are shared: that only over-invalidates
+    return 1ULL << (it->second & 63u);
+}
 
-    // Force next poll to accept the new state (and invalidate caches now)
-    activeRunwayFingerprint = 0ULL;
-    lastRunwayPollMs = 0;
-    InvalidateLoaCachesForRunwayChange();
+bool LOAPlugin::IsSectorOutranked(const std::string& sector, const std::string& mySector)
+{
+    // Same rule as the matcher's source-sector suppression
+    const uint16_t sectorId = sectorGraph.Id(sector);
+    const uint16_t me = sectorGraph.Id(mySector);
+    const uint16_t actual = ResolveControllingStationId(sectorId);
+    if (actual == SectorGraph::kNone || actual == me) return false;
+    return sectorGraph.Outranks(sectorId, actual, me);
 }
 
+void LOAPlugin::SetLoaSectorActive(const std::string& sector, bool active)
+{
+    auto tableIt = loadedSectorLoas.find(sector);
+    if (tableIt == loadedSectorLoas.end()) return;
+    if (active == (activeLoaSectors.count(sector) > 0)) return;
+
+    auto unindex = [](auto& index, const std::string& key, auto ptr) {
+            auto it = index.find(key);
+            if (it == index.end()) return;
+            auto& list = it->second;
+            list.erase(std::remove(list.begin(), list.end(), ptr), list.end());
+            if (list.empty()) index.erase(it);
+        };
+
+    const std::vector<LoaHotEntry>& hotTable = loadedSectorLoaHot[sector];
+    for (size_t i = 0; i < tableIt->second.size(); ++i) {
+        const LOAEntry& entry = tableIt->second[i];
+        const LOAEntry* ptr = &entry;
+        const LoaHotEntry* hot = &hotTable[i];
+        // Only the two main lists are indexed; fallbacks are scanned
+        const bool indexed = (entry.listKind == LOAListKind::Destination ||
+            entry.listKind == LOAListKind::Departure);
+
+        if (active) {
+            validLoaEntryPtrs.insert(ptr);
+            if (!indexed) continue;
+            // Waypoint buckets stay sorted by static score for the matcher's early stop
+            for (const std::string& wp : entry.waypoints) {
+                auto& bucket = indexByWaypoint[wp];
+                bucket.insert(std::upper_bound(bucket.begin(), bucket.end(), hot, LoaScoreOrder), hot);
+            }
+            for (const std::string& next : entry.nextSectors) indexByNextSector[next].push_back(ptr);
+        }
+        else {
+            validLoaEntryPtrs.erase(ptr);
+            if (!indexed) continue;
+            for (const std::string& wp : entry.waypoints) unindex(indexByWaypoint, wp, hot);
+            for (const std::string& next : entry.nextSectors) unindex(indexByNextSector, next, ptr);
+        }
+    }
+
+    if (active) activeLoaSectors.insert(sector);
+    else activeLoaSectors.erase(sector);
+}
 
-static inline std::string _TrimWS(std::string s)
+void LOAPlugin::RebuildActiveLoaLists()
 {
-    // Fast trim without repeated erase(begin()) O(n^2)
-    const char* ws = " \t\r\n";
-    const size_t start = s.find_first_not_of(ws);
-    if (start == std::string::npos) return std::string();
-    const size_t end = s.find_last_not_of(ws);
-    if (start == 0 && end + 1 == s.size()) return s;
-    return s.substr(start, end - start + 1);
+    // Pointer lists only, in load order (my sector first); entries themselves are not touched
+    destinationLoas.clear();
+    departureLoas.clear();
+    destinationFallbackLoas.clear();
+    departureFallbackLoas.clear();
+
+    for (const std::string& sector : loadedSectorOrder) {
+        if (!activeLoaSectors.count(sector)) continue;
+        auto hotIt = loadedSectorLoaHot.find(sector);
+        if (hotIt == loadedSectorLoaHot.end()) continue;
+
+        for (const LoaHotEntry& hot : hotIt->second) {
+            switch (hot.listKind) {
+            case LOAListKind::Destination:         destinationLoas.push_back(&hot); break;
+            case LOAListKind::Departure:           departureLoas.push_back(&hot); break;
+            case LOAListKind::DestinationFallback: destinationFallbackLoas.push_back(&hot); break;
+            case LOAListKind::DepartureFallback:   departureFallbackLoas.push_back(&hot); break;
+            default: break;
+            }
+        }
+    }
 }
 
-static inline std::string _ToUpper(std::string s)
+// ---------------- Active Airports/Runways (sector file) ----------------
+
+
+void LOAPlugin::OnAirportRunwayActivityChanged(void)
 {
-    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)std::toupper(c); });
-    return s;
+    // Some EuroScope builds fire this reliably, some don't. If it fires, refresh immediately;
+    // only flights at airports whose selection changed are invalidated.
+    UpdateActiveRunwaysFromSectorFile();
+    lastRunwayPollMs = GetTickCount64();
 }
 
 void LOAPlugin::UpdateActiveRunwaysFromSectorFile()
 {
-    activeDepRunwaysByAirport.clear();
-    activeArrRunwaysByAirport.clear();
+    const size_t knownAirports = runwayTable.AirportCount();
+    runwayTable.BeginScan();
 
     for (EuroScopePlugIn::CSectorElement sfe = SectorFileElementSelectFirst(EuroScopePlugIn::SECTOR_ELEMENT_RUNWAY);
         sfe.IsValid();
         sfe = SectorFileElementSelectNext(sfe, EuroScopePlugIn::SECTOR_ELEMENT_RUNWAY))
     {
-        std::string apt = _ToUpper(_TrimWS(std::string(sfe.GetAirportName())));
-        if (apt.empty()) continue;
+        const uint16_t apt = runwayTable.InternAirport(sfe.GetAirportName());
+        if (apt == RunwayTable::kNone) continue;
 
         for (int endIdx = 0; endIdx < 2; ++endIdx) {
-            std::string rw = _ToUpper(_TrimWS(std::string(sfe.GetRunwayName(endIdx))));
-            if (rw.empty()) continue;
+            const bool dep = sfe.IsElementActive(true, endIdx);
+            const bool arr = sfe.IsElementActive(false, endIdx);
+            if (!dep && !arr) continue;
 
-            if (sfe.IsElementActive(true, endIdx)) {
-                activeDepRunwaysByAirport[apt].insert(rw);
-            }
-            if (sfe.IsElementActive(false, endIdx)) {
-                activeArrRunwaysByAirport[apt].insert(rw);
-            }
+            const uint16_t rw = runwayTable.InternRunway(sfe.GetRunwayName(endIdx));
+            if (dep) runwayTable.MarkActive(apt, rw, true);
+            if (arr) runwayTable.MarkActive(apt, rw, false);
         }
     }
 
+    const bool newAirports = runwayTable.AirportCount() != knownAirports;
+    if (!runwayTable.CommitScan(runwayChanges) && !newAirports)
+        return;
+
     lastActiveRunwayRefreshMs = GetTickCount64();
+    InvalidateLoaCachesForRunwayChange(newAirports);
 }
 
-void LOAPlugin::InvalidateLoaCachesForRunwayChange()
+void LOAPlugin::InvalidateLoaCachesForRunwayChange(bool newAirports)
 {
-    ++sectorControlVersion;
+    LOA_TRACE_INSTANT("refresh", "RunwaysChanged", nullptr);
 
-    currentFrameMatchedEntry = nullptr;
-    currentFrameCallsign.clear();
+    // A flight matched before its airport was interned recorded no airport: rematch everything
+    if (newAirports) {
+        ++sectorControlVersion;
+        ResetFlightStates(FS_RESET_MATCH | FS_RESET_RENDER);
+        return;
+    }
 
-    matchedLOACache.clear();
-    matchTimestamps.clear();
-    matchVersions.clear();
-    renderCache.clear();
+    // Only flights whose match evaluated a runway constraint at a changed airport are rematched
+    auto changed = [&](uint16_t airport, uint8_t flag) -> bool {
+        return airport < runwayChanges.size() && (runwayChanges[airport] & flag) != 0;
+        };
+    flightStates.ForEach([&](uint32_t, FlightState& fs) {
+        if (!changed(fs.matchDepRunwayAirport, RunwayTable::CHANGED_DEP) &&
+            !changed(fs.matchArrRunwayAirport, RunwayTable::CHANGED_ARR))
+            return;
+        if (fs.matchTs != 0) LOA_CACHE_INVALIDATE(LOA_CACHE_MATCH, LOA_INVAL_RUNWAYS);
+        fs.ResetMatch();
+        fs.ResetRender();
+        });
 }
 
 void LOAPlugin::PollActiveRunwaysIfNeeded()
@@ -1650,161 +2235,89 @@ void LOAPlugin::PollActiveRunwaysIfNeeded()
     if (nowMs - lastRunwayPollMs < 5000ULL)
         return;
     lastRunwayPollMs = nowMs;
+    LOA_STATS_SCOPE(LOA_STAT_RUNWAY_POLL);
+    LOA_TRACE_SCOPE("refresh", "PollActiveRunways");
 
-    // Scan sector runway elements and build a fingerprint of active runway selections (DEP/ARR).
-    std::unordered_map<std::string, std::unordered_set<std::string>> tmpDep;
-    std::unordered_map<std::string, std::unordered_set<std::string>> tmpArr;
-
-    unsigned long long h = 1469598103934665603ULL; // FNV offset basis (64-bit)
-    auto hashMix = [&](const std::string& s)
-        {
-            for (size_t i = 0; i < s.size(); ++i) {
-                h ^= (unsigned char)s[i];
-                h *= 1099511628211ULL; // FNV prime
-            }
-        };
-
-    auto hashMixChar = [&](char c)
-        {
-            h ^= (unsigned char)c;
-            h *= 1099511628211ULL;
-        };
-
-
-    for (EuroScopePlugIn::CSectorElement sfe = SectorFileElementSelectFirst(EuroScopePlugIn::SECTOR_ELEMENT_RUNWAY);
-        sfe.IsValid();
-        sfe = SectorFileElementSelectNext(sfe, EuroScopePlugIn::SECTOR_ELEMENT_RUNWAY))
-    {
-        std::string apt = _ToUpper(_TrimWS(std::string(sfe.GetAirportName())));
-        if (apt.empty()) continue;
-
-        for (int endIdx = 0; endIdx < 2; ++endIdx)
-        {
-            std::string rw = _ToUpper(_TrimWS(std::string(sfe.GetRunwayName(endIdx))));
-            if (rw.empty()) continue;
-
-            if (sfe.IsElementActive(true, endIdx)) {
-                tmpDep[apt].insert(rw);
-                hashMixChar('D'); hashMixChar(':'); hashMix(apt); hashMixChar(':'); hashMix(rw);
-            }
-            if (sfe.IsElementActive(false, endIdx)) {
-                tmpArr[apt].insert(rw);
-                hashMixChar('A'); hashMixChar(':'); hashMix(apt); hashMixChar(':'); hashMix(rw);
-            }
-        }
-    }
-
-    if (h == activeRunwayFingerprint)
-        return;
-
-    // Runway selection changed -> swap in new caches and invalidate LOA/tag caches.
-    activeRunwayFingerprint = h;
-    activeDepRunwaysByAirport.swap(tmpDep);
-    activeArrRunwaysByAirport.swap(tmpArr);
-    lastActiveRunwayRefreshMs = nowMs;
-
-    InvalidateLoaCachesForRunwayChange();
+    UpdateActiveRunwaysFromSectorFile();
 }
 
 
-bool LOAPlugin::MatchesActiveRunway(
-    const std::string& airportIcao,
-    bool isDeparture,
-    const std::vector<std::string>& allowedRunways) const
+// -----------------------------------------------------------------------
+std::string LOAPlugin::ResolveControllingSector(const std::string& sector)
 {
-    if (allowedRunways.empty()) return true;
-
-    std::string apt = _ToUpper(_TrimWS(airportIcao));
-    if (apt.empty()) return false;
-
-    const auto& mapRef = isDeparture ? activeDepRunwaysByAirport : activeArrRunwaysByAirport;
-    auto it = mapRef.find(apt);
-    if (it == mapRef.end() || it->second.empty()) return false; // nothing selected in ES dialog
-
-    for (const auto& r : allowedRunways) {
-        // runways are normalized at JSON load (trimmed + uppercased)
-        if (!r.empty() && it->second.find(r) != it->second.end()) return true;
-    }
-    return false;
+    // Resolved against the maintained online set (onlineById)
+    const uint16_t station = ResolveControllingStationId(sectorGraph.Id(sector));
+    if (station == SectorGraph::kNone) return {}; // No one online
+    return sectorGraph.Name(station);
 }
 
-// -----------------------------------------------------------------------
-std::string LOAPlugin::ResolveControllingSector(const std::string& sector, const std::unordered_set<std::string>& onlineControllers)
+uint16_t LOAPlugin::ResolveControllingStationId(uint16_t sector)
 {
-    // Cache result per onlineControllersVersion (refreshed in GetOnlineControllersCached()).
-    // Assumption: callers pass a snapshot derived from GetOnlineControllersCached()/currentFrameOnlineControllers.
-    if (controllingSectorCacheVersion == onlineControllersVersion) {
-        auto it = controllingSectorCache.find(sector);
-        if (it != controllingSectorCache.end()) return it->second;
+    if (sector >= resolvedValid.size()) return SectorGraph::kNone;
+    if (resolvedValid[sector]) {
+        LOA_CACHE_HIT(LOA_CACHE_SECTOR_RESOLUTION);
+        return resolvedStation[sector];
     }
+    LOA_CACHE_MISS(LOA_CACHE_SECTOR_RESOLUTION);
 
-    auto prIt = sectorPriority.find(sector);
-    if (prIt != sectorPriority.end()) {
-        const auto& prioList = prIt->second;
-        for (const auto& s : prioList) {
-            if (onlineControllers.count(s)) {
-                if (controllingSectorCacheVersion == onlineControllersVersion)
-                    controllingSectorCache[sector] = s;
-                return s;
-            }
+    uint16_t station = SectorGraph::kNone;
+    for (uint16_t candidate : sectorGraph.Priority(sector)) {
+        if (onlineById[candidate]) {
+            station = candidate;
+            break;
         }
     }
+    resolvedStation[sector] = station;
+    resolvedValid[sector] = 1;
+    return station;
+}
 
-    if (controllingSectorCacheVersion == onlineControllersVersion)
-        controllingSectorCache[sector] = std::string();
-    return {}; // No one online
+void LOAPlugin::RebuildSectorGraphState()
+{
+    const size_t n = sectorGraph.Size();
+    LOA_CACHE_INVALIDATE(LOA_CACHE_SECTOR_RESOLUTION, LOA_INVAL_RELOAD);
+    resolvedStation.assign(n, SectorGraph::kNone);
+    resolvedValid.assign(n, 0);
+    onlineById.assign(n, 0);
+    for (const auto& station : cachedOnlineControllers) {
+        const uint16_t id = sectorGraph.Id(station);
+        if (id != SectorGraph::kNone) onlineById[id] = 1;
+    }
 }
 
 bool LOAPlugin::ShouldAllowNextSectors(
     const std::vector<std::string>& nextSectors,
     const std::unordered_set<std::string>& onlineControllers)
 {
-    std::string mySector = ControllerMyself().GetPositionId();
-
-    std::vector<std::string> owned;
-    auto ownIt = sectorOwnership.find(mySector);
-    if (ownIt != sectorOwnership.end()) owned = ownIt->second;
+    const uint16_t me = sectorGraph.Id(ControllerMyself().GetPositionId());
 
     for (const std::string& next : nextSectors) {
-        const bool nextIsDefined = (sectorOwnership.find(next) != sectorOwnership.end());
-        const bool iOwnNext = (std::find_if(owned.begin(), owned.end(),
-            [&](const std::string& s) { return _stricmp(s.c_str(), next.c_str()) == 0; }) != owned.end());
+        const uint16_t nextId = sectorGraph.Id(next);
+        const bool nextIsDefined = sectorGraph.IsDefined(nextId);
+        const bool iOwnNext = sectorGraph.Owns(me, nextId);
 
-        std::string actualController = ResolveControllingSector(next, onlineControllers);
+        const uint16_t actualController = ResolveControllingStationId(nextId);
+        const bool nobodyOnline = (actualController == SectorGraph::kNone);
 
-        if (!actualController.empty() && _stricmp(actualController.c_str(), mySector.c_str()) == 0)
+        if (!nobodyOnline && actualController == me)
             return false;
 
         if (nextIsDefined) {
-            if (iOwnNext && actualController.empty())
+            if (iOwnNext && nobodyOnline)
                 return false;
 
-            auto prIt = sectorPriority.find(next);
-            if (prIt != sectorPriority.end()) {
-                const auto& prioList = prIt->second;
-                auto myPrio = std::find_if(prioList.begin(), prioList.end(),
-                    [&](const std::string& s) { return _stricmp(s.c_str(), mySector.c_str()) == 0; });
-                auto otherPrio = std::find_if(prioList.begin(), prioList.end(),
-                    [&](const std::string& s) { return _stricmp(s.c_str(), actualController.c_str()) == 0; });
-
-                // Owned-sector rule: allow only when other controller outranks me
-                if (iOwnNext) {
-                    if (myPrio != prioList.end() && otherPrio != prioList.end() && otherPrio < myPrio)
-                        return true;
-                    return false;
-                }
+            // Owned-sector rule: allow only when other controller outranks me
+            if (iOwnNext && !sectorGraph.Priority(nextId).empty())
+                return sectorGraph.Outranks(nextId, actualController, me);
 
-                // Non-owned defined sector: suppress if I outrank the controlling sector
-                if (myPrio != prioList.end() && otherPrio != prioList.end() && myPrio < otherPrio)
-                    return false;
-            }
+            // Non-owned defined sector: suppress if I outrank the controlling sector
+            if (sectorGraph.Outranks(nextId, me, actualController))
+                return false;
 
             return true;
         }
 
         // External sector
-        if (actualController.empty()) return true;
-        if (!_stricmp(actualController.c_str(), mySector.c_str())) return false;
         return true;
     }
 
@@ -1817,31 +2330,14 @@ bool LOAPlugin::IsSourceSectorSuppressed(
 {
     if (e.sectors.empty()) return false;
 
-    std::string my = ControllerMyself().GetPositionId();
-    std::unordered_map<std::string, std::string> resolveCache;
+    const uint16_t me = sectorGraph.Id(ControllerMyself().GetPositionId());
 
     for (const auto& src : e.sectors) {
-        std::string actual;
-        auto it = resolveCache.find(src);
-        if (it != resolveCache.end()) actual = it->second;
-        else {
-            actual = ResolveControllingSector(src, onlineControllers);
-            resolveCache[src] = actual;
-        }
-
-        if (actual.empty()) continue;
-        if (_stricmp(actual.c_str(), my.c_str()) == 0) continue;
-
-        auto prIt = sectorPriority.find(src);
-        if (prIt == sectorPriority.end()) continue;
+        const uint16_t srcId = sectorGraph.Id(src);
+        const uint16_t actual = ResolveControllingStationId(srcId);
+        if (actual == SectorGraph::kNone || actual == me) continue;
 
-        const auto& prio = prIt->second;
-        auto meIt = std::find_if(prio.begin(), prio.end(),
-            [&](const std::string& s) { return _stricmp(s.c_str(), my.c_str()) == 0; });
-        auto himIt = std::find_if(prio.begin(), prio.end(),
-            [&](const std::string& s) { return _stricmp(s.c_str(), actual.c_str()) == 0; });
-
-        if (meIt != prio.end() && himIt != prio.end() && himIt < meIt)
+        if (sectorGraph.Outranks(srcId, actual, me))
             return true;
     }
 
@@ -1864,33 +2360,202 @@ bool LOAPlugin::IsLOARelevantState(int state) {
     }
 }
 
+// ---------------- Online controllers ----------------
+// The online set follows controller events instead of being rebuilt on a timer.
+// onlineControllersVersion only moves when a station really comes or goes, and the
+// sector-resolution cache drops only the sectors such a change can affect.
+// A full scan every 60 s seeds the set and repairs anything an event missed.
+
+static const ULONGLONG kOnlineReconcileIntervalMs = 60000ULL;
+
 const std::unordered_set<std::string>& LOAPlugin::GetOnlineControllersCached()
 {
-    ULONGLONG currentTime = GetTickCount64();
-    if (currentTime - lastOnlineFetchTime > 5000 || cachedOnlineControllers.empty()) {
-        cachedOnlineControllers.clear();
-        onlineControllersVersion++;
-        controllingSectorCache.clear();
-        controllingSectorCacheVersion = onlineControllersVersion;
-        for (EuroScopePlugIn::CController c = ControllerSelectFirst(); c.IsValid(); c = ControllerSelectNext(c)) {
-            cachedOnlineControllers.insert(c.GetPositionId());
-        }
-        lastOnlineFetchTime = currentTime;
+    const ULONGLONG currentTime = GetTickCount64();
+    if (!onlineControllersSeeded) {
+        LOA_CACHE_MISS(LOA_CACHE_ONLINE_CONTROLLERS);
+        ReconcileOnlineControllers(currentTime);
+    }
+    else if (currentTime - lastOnlineFetchTime > kOnlineReconcileIntervalMs) {
+        LOA_CACHE_INVALIDATE(LOA_CACHE_ONLINE_CONTROLLERS, LOA_INVAL_TTL);
+        ReconcileOnlineControllers(currentTime);
+    }
+    else {
+        LOA_CACHE_HIT(LOA_CACHE_ONLINE_CONTROLLERS);
     }
     return cachedOnlineControllers;
 }
 
+void LOAPlugin::RetainOnlineStation(const std::string& positionId, OnlineControllersDiff& diff)
+{
+    if (++onlineStationRefs[positionId] == 1) {
+        cachedOnlineControllers.insert(positionId);
+        diff.added.push_back(positionId);
+        const uint16_t id = sectorGraph.Id(positionId);
+        if (id != SectorGraph::kNone) onlineById[id] = 1;
+    }
+}
+
+void LOAPlugin::ReleaseOnlineStation(const std::string& positionId, OnlineControllersDiff& diff)
+{
+    auto it = onlineStationRefs.find(positionId);
+    if (it == onlineStationRefs.end()) return;
+    if (--it->second <= 0) {
+        onlineStationRefs.erase(it);
+        cachedOnlineControllers.erase(positionId);
+        diff.removed.push_back(positionId);
+        const uint16_t id = sectorGraph.Id(positionId);
+        if (id != SectorGraph::kNone) onlineById[id] = 0;
+    }
+}
+
+void LOAPlugin::TrackControllerStation(const std::string& callsign, const std::string& positionId)
+{
+    if (callsign.empty()) return;
+
+    OnlineControllersDiff diff;
+    auto it = onlineStationByCallsign.find(callsign);
+    if (it != onlineStationByCallsign.end()) {
+        if (it->second == positionId) return; // position update without a station change
+        ReleaseOnlineStation(it->second, diff);
+        onlineStationByCallsign.erase(it);
+    }
+    if (!positionId.empty()) {
+        onlineStationByCallsign.emplace(callsign, positionId);
+        RetainOnlineStation(positionId, diff);
+    }
+    PublishOnlineControllersDiff(diff);
+}
+
+static void FormatContactFrequency(ControllerContact& contact, double mhz)
+{
+    if (!contact.frequency.empty() && mhz == contact.frequencyMhz) return;
+    char fbuf[16] = {};
+    _snprintf_s(fbuf, sizeof(fbuf), _TRUNCATE, "%.3f", mhz);
+    contact.frequency = fbuf;
+    contact.frequencyMhz = mhz;
+}
+
+// Called before TrackControllerStation, so onlineStationByCallsign still has the old position
+void LOAPlugin::UpdateControllerContact(EuroScopePlugIn::CController controller)
+{
+    const char* cs = controller.GetCallsign();
+    const char* pos = controller.GetPositionId();
+    if (!cs || !cs[0]) return;
+
+    auto old = onlineStationByCallsign.find(cs);
+    if (old != onlineStationByCallsign.end() && (!pos || old->second != pos))
+        RemoveControllerContact(cs);
+    if (!controller.IsController() || !pos || !pos[0]) return;
+
+    const uint16_t id = controllerDirectory.Intern(pos);
+    if (id == ControllerDirectory::kNone) return;
+    ControllerContact& contact = controllerDirectory.At(id);
+    if (contact.callsign != cs) contact.callsign = cs;
+    FormatContactFrequency(contact, controller.GetPrimaryFrequency());
+}
+
+void LOAPlugin::RemoveControllerContact(const std::string& callsign)
+{
+    auto old = onlineStationByCallsign.find(callsign);
+    if (old == onlineStationByCallsign.end()) return;
+    const uint16_t id = controllerDirectory.Id(old->second);
+    // Another controller at the same position may have updated it since
+    if (id != ControllerDirectory::kNone && controllerDirectory.At(id).callsign == callsign)
+        controllerDirectory.Remove(id);
+}
+
+void LOAPlugin::PublishOnlineControllersDiff(OnlineControllersDiff& diff)
+{
+    if (diff.added.empty() && diff.removed.empty()) return;
+
+    diff.version = ++onlineControllersVersion;
+
+    // A resolution can only change if its station went offline or a station from its
+    // priority list came online
+    std::vector<uint16_t> addedIds;
+    std::vector<uint16_t> removedIds;
+    for (const auto& station : diff.added) {
+        const uint16_t id = sectorGraph.Id(station);
+        if (id != SectorGraph::kNone) addedIds.push_back(id);
+    }
+    for (const auto& station : diff.removed) {
+        const uint16_t id = sectorGraph.Id(station);
+        if (id != SectorGraph::kNone) removedIds.push_back(id);
+    }
+    for (uint16_t sector = 0; sector < (uint16_t)resolvedValid.size(); ++sector) {
+        if (!resolvedValid[sector]) continue;
+        bool affected = std::find(removedIds.begin(), removedIds.end(), resolvedStation[sector]) != removedIds.end();
+        for (size_t k = 0; !affected && k < addedIds.size(); ++k) {
+            affected = sectorGraph.Rank(sector, addedIds[k]) != SectorGraph::kUnranked;
+        }
+        if (affected) {
+            resolvedValid[sector] = 0;
+            LOA_CACHE_INVALIDATE(LOA_CACHE_SECTOR_RESOLUTION, LOA_INVAL_CONTROLLER);
+        }
+    }
+
+    lastOnlineDiff = std::move(diff);
+}
+
+void LOAPlugin::ReconcileOnlineControllers(ULONGLONG nowMs)
+{
+    lastOnlineFetchTime = nowMs;
+    onlineControllersSeeded = true;
+
+    std::unordered_map<std::string, std::string> byCallsign;
+    std::vector<uint8_t> seen(controllerDirectory.Size(), 0);
+    for (EuroScopePlugIn::CController c = ControllerSelectFirst(); c.IsValid(); c = ControllerSelectNext(c)) {
+        const char* cs = c.GetCallsign();
+        const char* pos = c.GetPositionId();
+        if (!cs || !cs[0] || !pos || !pos[0]) continue;
+        byCallsign[cs] = pos;
+        if (!c.IsController()) continue;
+
+        // Formatted frequencies that did not change are kept
+        const uint16_t id = controllerDirectory.Intern(pos);
+        if (id == ControllerDirectory::kNone) continue;
+        if (id >= seen.size()) seen.resize(controllerDirectory.Size(), 0);
+        seen[id] = 1;
+        ControllerContact& contact = controllerDirectory.At(id);
+        if (contact.callsign != cs) contact.callsign = cs;
+        FormatContactFrequency(contact, c.GetPrimaryFrequency());
+    }
+    for (uint16_t id = 0; id < (uint16_t)seen.size(); ++id) {
+        if (!seen[id]) controllerDirectory.Remove(id);
+    }
+    if (byCallsign == onlineStationByCallsign) return;
+
+    // Missed events: rebuild the ref counts and publish what actually changed
+    std::unordered_map<std::string, int> refs;
+    for (const auto& kv : byCallsign) ++refs[kv.second];
+
+    OnlineControllersDiff diff;
+    for (const auto& kv : refs) {
+        if (!cachedOnlineControllers.count(kv.first)) diff.added.push_back(kv.first);
+    }
+    for (const auto& station : cachedOnlineControllers) {
+        if (!refs.count(station)) diff.removed.push_back(station);
+    }
+
+    onlineStationByCallsign.swap(byCallsign);
+    onlineStationRefs.swap(refs);
+    cachedOnlineControllers.clear();
+    std::fill(onlineById.begin(), onlineById.end(), (uint8_t)0);
+    for (const auto& kv : onlineStationRefs) {
+        cachedOnlineControllers.insert(kv.first);
+        const uint16_t id = sectorGraph.Id(kv.first);
+        if (id != SectorGraph::kNone) onlineById[id] = 1;
+    }
+
+    PublishOnlineControllersDiff(diff);
+}
+
 std::string LOAPlugin::GetIndicatedNextSectorStation(const std::string& nextSector)
 {
     if (nextSector.empty()) return {};
 
-    // Use the cached online controllers snapshot if available.
-    const auto& online = !currentFrameOnlineControllers.empty()
-        ? currentFrameOnlineControllers
-        : GetOnlineControllersCached();
-
     // Resolve who currently controls the next sector (dynamic ownership logic)
-    std::string controlling = ResolveControllingSector(nextSector, online);
+    std::string controlling = ResolveControllingSector(nextSector);
 
     // If nobody is online or it's our own sector, show nothing.
     const std::string me = ControllerMyself().GetPositionId();
@@ -1902,30 +2567,16 @@ std::string LOAPlugin::GetIndicatedNextSectorStation(const std::string& nextSect
 
 std::string LOAPlugin::GetPredictedNextController(const EuroScopePlugIn::CFlightPlan& fp)
 {
-    EuroScopePlugIn::CFlightPlanPositionPredictions preds = fp.GetPositionPredictions();
-    int n = preds.GetPointsNumber();
-    if (n <= 0) return {};
-
     std::string myId = ControllerMyself().GetPositionId();
 
-    std::string last;
-
-    for (int i = 0; i < n; ++i) {
-        const char* id = preds.GetControllerId(i);
-        if (!id || !id[0]) continue;
-
-        // Skip repeats
-        if (!last.empty() && _stricmp(id, last.c_str()) == 0)
-            continue;
-
+    // Sequence is already free of consecutive repeats
+    for (const std::string& id : GetPredictedControllerSequence(fp)) {
         // Skip my own sector
-        if (!myId.empty() && _stricmp(id, myId.c_str()) == 0) {
-            last = id;
+        if (!myId.empty() && _stricmp(id.c_str(), myId.c_str()) == 0)
             continue;
-        }
 
-        // First non-own, non-repeat controller → this is our predicted next
-        return std::string(id);
+        // First non-own controller → this is our predicted next
+        return id;
     }
 
     // No suitable next controller found
@@ -1934,7 +2585,7 @@ std::string LOAPlugin::GetPredictedNextController(const EuroScopePlugIn::CFlight
 
 std::vector<std::string> LOAPlugin::BuildHybridPredictedSectorList(
     const EuroScopePlugIn::CFlightPlan& fp,
-    const std::unordered_set<std::string>& onlineControllers,
+    const std::unordered_set<std::string>& /*onlineControllers*/,
     size_t* outLoaCount)
 {
     std::vector<std::string> result;
@@ -1945,14 +2596,14 @@ std::vector<std::string> LOAPlugin::BuildHybridPredictedSectorList(
 
     std::string myId = ControllerMyself().GetPositionId();
 
-    const LOAEntry* match = MatchLoaEntry(fp, onlineControllers);
+    const LOAEntry* match = MatchLoaEntry(fp);
 
     // 1) LOA-based next sectors first (match already includes altitude gating)
     if (match && !match->nextSectors.empty()) {
         for (const std::string& next : match->nextSectors) {
             if (next.empty()) continue;
 
-            std::string controlling = ResolveControllingSector(next, onlineControllers);
+            std::string controlling = ResolveControllingSector(next);
             const std::string& key = controlling.empty() ? next : controlling;
 
             // Skip myself; skip duplicates
@@ -1969,33 +2620,18 @@ std::vector<std::string> LOAPlugin::BuildHybridPredictedSectorList(
     if (outLoaCount)
         *outLoaCount = loaAdded;
 
-    // 2) ES controller prediction (unchanged) — this always runs,
+    // 2) Route-based prediction (sector-file polygons) — this always runs,
     // but anything already seeded by LOA is skipped via "seen".
-    EuroScopePlugIn::CFlightPlanPositionPredictions preds = fp.GetPositionPredictions();
-    int n = preds.GetPointsNumber();
-    if (n > 0) {
-        std::string last;
-
-        for (int i = 0; i < n; ++i) {
-            const char* id = preds.GetControllerId(i);
-            if (!id || !id[0]) continue;
-
-            // Skip consecutive repeats
-            if (!last.empty() && _stricmp(id, last.c_str()) == 0)
-                continue;
-
-            last = id;
-
-            // Skip my own sector
-            if (!myId.empty() && _stricmp(id, myId.c_str()) == 0)
-                continue;
+    for (const std::string& id : GetPredictedControllerSequence(fp)) {
+        // Skip my own sector
+        if (!myId.empty() && _stricmp(id.c_str(), myId.c_str()) == 0)
+            continue;
 
-            // Skip anything already seeded by LOA
-            if (!seen.insert(id).second)
-                continue;
+        // Skip anything already seeded by LOA
+        if (!seen.insert(id).second)
+            continue;
 
-            result.emplace_back(id);
-        }
+        result.push_back(id);
     }
 
     return result;
@@ -2029,7 +2665,7 @@ bool LOAPlugin::IsAnyAORHostOnline(const std::unordered_set<std::string>& online
 
     for (const auto& host : aorHostSectors) {
         // Which station controls this AOR sector right now?
-        std::string ctrl = const_cast<LOAPlugin*>(this)->ResolveControllingSector(host, onlineControllers);
+        std::string ctrl = const_cast<LOAPlugin*>(this)->ResolveControllingSector(host);
         if (!ctrl.empty() && _stricmp(ctrl.c_str(), myId.c_str()) == 0) {
             // I currently own this AOR sector (directly or via ownership tree)
             return true;
@@ -2039,26 +2675,23 @@ bool LOAPlugin::IsAnyAORHostOnline(const std::unordered_set<std::string>& online
 }
 
 const std::vector<std::string>& LOAPlugin::GetCachedRoutePoints(const EuroScopePlugIn::CFlightPlan& fp) {
-    static std::vector<std::string> empty;
-
-    std::string callsign = fp.GetCallsign();
+    FlightState& fs = GetFlightState(fp);
     ULONGLONG now = GetTickCount64();
 
-    auto itTime = routeCacheTime.find(callsign);
-    if (itTime != routeCacheTime.end() && now - itTime->second < 5000) {
-        auto itPts = routeCache.find(callsign);
-        if (itPts != routeCache.end()) return itPts->second;
+    if (fs.routeTs != 0 && now - fs.routeTs < 5000) {
+        LOA_CACHE_HIT(LOA_CACHE_ROUTE);
+        return fs.routePoints;
     }
+    if (fs.routeTs != 0) LOA_CACHE_INVALIDATE(LOA_CACHE_ROUTE, LOA_INVAL_TTL);
+    else LOA_CACHE_MISS(LOA_CACHE_ROUTE);
 
     auto route = fp.GetExtractedRoute();
-    std::vector<std::string> routePoints;
+    fs.routePoints.clear();
     for (int i = 0; i < route.GetPointsNumber(); ++i)
-        routePoints.emplace_back(route.GetPointName(i));
+        fs.routePoints.emplace_back(route.GetPointName(i));
 
-    routeCacheTime[callsign] = now;
-    auto& resultPts = routeCache[callsign];
-    resultPts = std::move(routePoints);
-    return resultPts;
+    fs.routeTs = now;
+    return fs.routePoints;
 }
 
 bool LOAPlugin::IsLoaEntryPointerValid(const LOAEntry* entry) const
@@ -2067,64 +2700,63 @@ bool LOAPlugin::IsLoaEntryPointerValid(const LOAEntry* entry) const
 }
 
 void LOAPlugin::CleanupCache(const std::string& callsign) {
-    matchedLOACache.erase(callsign);
-    routeCache.erase(callsign);
-    routeCacheTime.erase(callsign);
-    routeSetCache.erase(callsign);
-    routeSetCacheTime.erase(callsign);
-    coordinationStates.erase(callsign);
-    matchTimestamps.erase(callsign);
-    matchVersions.erase(callsign);
-    lastDestinationByCallsign.erase(callsign);
-
-    if (_stricmp(currentFrameCallsign.c_str(), callsign.c_str()) == 0) {
-        currentFrameMatchedEntry = nullptr;
-        currentFrameCallsign.clear();
-        currentFrameRoutePoints.clear();
-        currentFrameRouteSet.clear();
-        currentFrameTimestamp = 0;
+    if (FlightState* fs = FindFlightState(callsign)) {
+        fs->ResetMatch();
+        fs->ResetRoute();
+        fs->coordination = CoordinationInfo();
+        fs->hasLastDestination = false;
     }
 }
 
 void LOAPlugin::PrunePerformanceCaches(ULONGLONG nowMs)
 {
+    LOA_TRACE_SCOPE("cache", "PrunePerformanceCaches");
     // Keep long sessions stable even if many callsigns come and go.
     // These caches are only accelerators; clearing old entries does not remove plugin features.
     const ULONGLONG routeTtlMs = 60000ULL;
     const ULONGLONG matchTtlMs = 60000ULL;
-
-    for (auto it = routeCacheTime.begin(); it != routeCacheTime.end(); ) {
-        if (nowMs - it->second > routeTtlMs) {
-            const std::string cs = it->first;
-            it = routeCacheTime.erase(it);
-            routeCache.erase(cs);
-            routeSetCache.erase(cs);
-            routeSetCacheTime.erase(cs);
-            routeSignature.erase(cs);
-            lastDestinationByCallsign.erase(cs);
+    const ULONGLONG flightTtlMs = 600000ULL;
+
+    std::vector<uint32_t> stale;
+    flightStates.ForEach([&](uint32_t slot, FlightState& fs) {
+        // Records are freed on disconnect; this only catches flights that never got one
+        if (nowMs - fs.lastSeenMs > flightTtlMs) {
+            if (fs.matchTs != 0) LOA_CACHE_EVICT(LOA_CACHE_MATCH, 1);
+            if (fs.routeTs != 0) LOA_CACHE_EVICT(LOA_CACHE_ROUTE, 1);
+            if (fs.routeSetTs != 0) LOA_CACHE_EVICT(LOA_CACHE_ROUTE_SET, 1);
+            stale.push_back(slot);
+            return;
         }
-        else {
-            ++it;
+        if (fs.routeTs != 0 && nowMs - fs.routeTs > routeTtlMs) {
+            LOA_CACHE_EVICT(LOA_CACHE_ROUTE, 1);
+            if (fs.routeSetTs != 0) LOA_CACHE_EVICT(LOA_CACHE_ROUTE_SET, 1);
+            fs.ResetRoute();
+            fs.hasRouteSignature = false;
+            fs.hasLastDestination = false;
+            std::vector<std::string>().swap(fs.routePoints);
+            std::unordered_set<std::string>().swap(fs.routeSet);
         }
-    }
-
-    for (auto it = matchTimestamps.begin(); it != matchTimestamps.end(); ) {
-        if (nowMs - it->second > matchTtlMs) {
-            const std::string cs = it->first;
-            it = matchTimestamps.erase(it);
-            matchedLOACache.erase(cs);
-            matchVersions.erase(cs);
+        if (fs.matchTs != 0 && nowMs - fs.matchTs > matchTtlMs) {
+            LOA_CACHE_EVICT(LOA_CACHE_MATCH, 1);
+            fs.ResetMatch();
         }
-        else {
-            ++it;
+        for (TagBundle& b : fs.bundles) {
+            if (b.ts != 0 && nowMs - b.ts > matchTtlMs) {
+                LOA_CACHE_EVICT(LOA_CACHE_TAG_BUNDLE, 1);
+                b.ts = 0;
+                b.validMask = 0;
+            }
         }
-    }
+        });
 
-    // Render cache keys are callsign:itemCode. If it grows unexpectedly, clear it;
-    // the next render will rebuild values immediately.
-    if (renderCache.size() > 2000) {
-        renderCache.clear();
+    for (uint32_t slot : stale) {
+        flightStates.Release(slot);
     }
+
+    // High-water mark for ".loa mem": long sessions should plateau, not creep
+    const size_t footprint = flightStates.FootprintBytes();
+    if (footprint > flightStatePeakBytes) flightStatePeakBytes = footprint;
+    if (flightStates.Size() > flightStatePeakLive) flightStatePeakLive = flightStates.Size();
 }
 
 void LOAPlugin::OnFlightPlanStateChange(EuroScopePlugIn::CFlightPlan fp) {
@@ -2135,21 +2767,29 @@ void LOAPlugin::OnFlightPlanStateChange(EuroScopePlugIn::CFlightPlan fp) {
         std::string cs = fp.GetCallsign();
 
         CleanupCache(cs);
-        activeHandoffTargets.erase(cs);
+        if (FlightState* fs = FindFlightState(cs)) fs->activeHandoffTarget.clear();
 
         // Also clear rendered Next Sector tag so new color/text appears immediately
-        std::string key = cs + ":" + std::to_string(ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL);
-        renderCache.erase(key);
+        InvalidateRenderItem(cs, ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL);
     }
 }
 
 
+void LOAPlugin::OnFlightPlanDisconnect(EuroScopePlugIn::CFlightPlan fp)
+{
+    const char* cs = fp.GetCallsign();
+    if (!cs || !cs[0]) return;
+
+    CleanupCache(cs);
+    flightStates.Release(flightStates.Find(cs));
+}
+
+
 void LOAPlugin::OnFlightPlanCoordinationStateChange(CFlightPlan fp, int coordinationType, int newState)
 {
     if (!fp.IsValid()) return;
 
-    const std::string callsign = fp.GetCallsign();
-    CoordinationInfo& info = coordinationStates[callsign];
+    CoordinationInfo& info = GetFlightState(fp).coordination;
 
     if (coordinationType == EuroScopePlugIn::TAG_ITEM_TYPE_COPN_COPX_NAME) {
         const std::string raw = fp.GetExitCoordinationPointName();
@@ -2235,65 +2875,66 @@ void LOAPlugin::OnFlightPlanCoordinationStateChange(CFlightPlan fp, int coordina
 }
 
 void LOAPlugin::CheckForOwnershipChange() {
+    LOA_STATS_SCOPE(LOA_STAT_OWNERSHIP_CHECK);
+    LOA_TRACE_SCOPE("refresh", "CheckForOwnershipChange");
     std::string mySector = ControllerMyself().GetPositionId();
-    if (mySector.empty()) return;
-
-    std::vector<std::string> checkSectors;
-    auto ownIt = sectorOwnership.find(mySector);
-    if (ownIt != sectorOwnership.end()) checkSectors = ownIt->second;
-    checkSectors.push_back(mySector);
-
-    // Snapshot only the per-sector resolved strings (avoids copying the full online set)
-    std::vector<std::string> oldResolved;
-    oldResolved.reserve(checkSectors.size());
-    for (const auto& s : checkSectors)
-        oldResolved.push_back(ResolveControllingSector(s, currentFrameOnlineControllers));
+    if (mySector.empty() || mySector != loadedSector) return; // position changes reload everything
 
     currentFrameOnlineControllers = GetOnlineControllersCached();
-
-    bool changed = false;
-    for (size_t i = 0; i < checkSectors.size(); ++i) {
-        const std::string newCtrl = ResolveControllingSector(checkSectors[i], currentFrameOnlineControllers);
-        if (_stricmp(newCtrl.c_str(), oldResolved[i].c_str()) != 0) {
-            changed = true;
-            break;
-        }
+    if (onlineControllersVersion == ownershipCheckVersion) return;
+    ownershipCheckVersion = onlineControllersVersion;
+
+    // Which of the sectors my LOAs depend on (sources + next sectors) changed controller
+    uint64_t changedMask = 0;
+    std::vector<std::string> changedSources;
+    for (auto& kv : trackedSectorControl) {
+        std::string station = ResolveControllingSector(kv.first);
+        if (station == kv.second) continue;
+        kv.second.swap(station);
+        changedMask |= SectorMaskBit(kv.first);
+        if (loadedSectorLoas.count(kv.first)) changedSources.push_back(kv.first);
+    }
+    if (changedMask == 0) return;
+
+    // Source sectors that I gained or lost: switch only their entries in/out of the active tables
+    bool tablesChanged = false;
+    for (const std::string& sector : changedSources) {
+        const bool active = !IsSectorOutranked(sector, mySector);
+        if (active != (activeLoaSectors.count(sector) > 0)) {
+            SetLoaSectorActive(sector, active);
+            tablesChanged = true;
+        }
+    }
+
+    if (tablesChanged) {
+        LOA_TRACE_INSTANT("refresh", "LoaTablesChanged", nullptr);
+        RebuildActiveLoaLists();
+        // Newly active entries may match flights that never saw them as candidates
+        ++sectorControlVersion;
+        ResetFlightStates(FS_RESET_MATCH | FS_RESET_COORDINATION);
+        return;
     }
 
-    // 🚀 Only if something changed do we rebuild LOAs
-    if (changed) {
-        reloading = true;  // <── Begin reload guard
-
-        plugin.sectorControlVersion++;
-        plugin.matchedLOACache.clear();
-        plugin.matchTimestamps.clear();
-        plugin.routeCache.clear();
-        plugin.routeCacheTime.clear();
-        plugin.coordinationStates.clear();
-        plugin.matchVersions.clear();
-
-        LoadLOAsFromJSON();
-
-        // Bulk-clear the caches not already cleared above (replaces per-aircraft CleanupCache loop)
-        routeSetCache.clear();
-        routeSetCacheTime.clear();
-        lastDestinationByCallsign.clear();
-        currentFrameMatchedEntry = nullptr;
-        currentFrameCallsign.clear();
-        currentFrameRoutePoints.clear();
-        currentFrameRouteSet.clear();
-        currentFrameTimestamp = 0;
-        currentFrameRenderData = PerAircraftFrameData{};
-
-        reloading = false;
-    }
+    // Only flights whose candidate entries involve a changed sector are rematched
+    flightStates.ForEach([&](uint32_t, FlightState& fs) {
+        if ((fs.matchSectorMask & changedMask) == 0) return;
+        if (fs.matchTs != 0) LOA_CACHE_INVALIDATE(LOA_CACHE_MATCH, LOA_INVAL_CONTROLLER);
+        fs.ResetMatch();
+        fs.coordination = CoordinationInfo();
+        fs.ResetRender();
+        });
 }
 
 void LOAPlugin::OnGetControllerList() {
     CheckForOwnershipChange(); // ✅ Detect change and force rematch
 }
 
-void LOAPlugin::OnControllerDisconnect(const EuroScopePlugIn::CController& controller) {
+void LOAPlugin::OnControllerDisconnect(EuroScopePlugIn::CController controller) {
+    const char* controllerCallsign = controller.GetCallsign();
+    if (controllerCallsign) {
+        RemoveControllerContact(controllerCallsign);
+        TrackControllerStation(controllerCallsign, std::string());
+    }
     CheckForOwnershipChange();
 }
 
@@ -2308,6 +2949,8 @@ void LOAPlugin::OnFunctionCall(
         // 1) Click on the tag -> open the LOA + route next-sector popup
         // -----------------------------------------------------------------
         if (FunctionId == FunctionIds::NEXT_SECTOR_HANDOFF_MENU) {
+            LOA_STATS_SCOPE(LOA_STAT_HANDOFF_POPUP); // click to visible (ShowCustomHandoffPopup paints synchronously)
+            LOA_TRACE_SCOPE("popup", "BuildHandoffMenu");
 
             // Use ASEL as the clicked aircraft
             EuroScopePlugIn::CFlightPlan fp = FlightPlanSelectASEL();
@@ -2359,24 +3002,16 @@ void LOAPlugin::OnFunctionCall(
                 size_t loaCount = 0;
                 std::vector<std::string> hybridList = BuildHybridPredictedSectorList(fp, online, &loaCount);
 
-                // Single pass over all controllers to build posId -> (callsign, freq) map
-                std::unordered_map<std::string, std::pair<std::string, std::string>> controllerInfoByPosId;
-                for (EuroScopePlugIn::CController c = ControllerSelectFirst(); c.IsValid(); c = ControllerSelectNext(c)) {
-                    if (!c.IsController()) continue;
-                    char fbuf[16] = {};
-                    _snprintf_s(fbuf, sizeof(fbuf), _TRUNCATE, "%.3f", c.GetPrimaryFrequency());
-                    controllerInfoByPosId[c.GetPositionId()] = { c.GetCallsign(), std::string(fbuf) };
-                }
-
                 for (size_t i = 0; i < hybridList.size(); ++i) {
                     const auto& cid = hybridList[i];
                     const bool isLoaSeeded = (i < loaCount);
                     if (online.count(cid) == 0)
                         continue;
 
-                    auto ctIt = controllerInfoByPosId.find(cid);
-                    if (ctIt != controllerInfoByPosId.end()) {
-                        options.push_back({ cid, ctIt->second.first, ctIt->second.second, isLoaSeeded });
+                    // Callsign + formatted frequency, maintained from controller updates
+                    const ControllerContact* contact = controllerDirectory.Find(cid);
+                    if (contact) {
+                        options.push_back({ cid, contact->callsign, contact->frequency, isLoaSeeded });
                     }
                 }
             }
@@ -2573,28 +3208,19 @@ void LOAPlugin::OnFunctionCall(
             if (!fp.IsValid())
                 return;
 
-            for (EuroScopePlugIn::CController c = ControllerSelectFirst();
-                c.IsValid();
-                c = ControllerSelectNext(c))
-            {
-                if (!c.IsController()) continue;
-
-                if (_stricmp(c.GetPositionId(), controlling.c_str()) != 0)
-                    continue;
-
-                fp.InitiateHandoff(c.GetCallsign());
+            const ControllerContact* target = controllerDirectory.Find(controlling);
+            if (!target)
+                return;
 
-                // ✅ Remember handoff target for this callsign so the Next Sector tag
-                // can show it while TRANSFER_FROM_ME_INITIATED.
-                std::string cs = fp.GetCallsign();
-                activeHandoffTargets[cs] = controlling;
+            fp.InitiateHandoff(target->callsign.c_str());
 
-                // Bust the micro-cache for the Next Sector tag so it updates immediately
-                std::string key = cs + ":" + std::to_string(ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL);
-                renderCache.erase(key);
+            // ✅ Remember handoff target for this callsign so the Next Sector tag
+            // can show it while TRANSFER_FROM_ME_INITIATED.
+            std::string cs = fp.GetCallsign();
+            GetFlightState(fp).activeHandoffTarget = controlling;
 
-                break;
-            }
+            // Bust the micro-cache for the Next Sector tag so it updates immediately
+            InvalidateRenderItem(cs, ItemCodes::TAG_ITEM_NEXT_SECTOR_CTRL);
 
             return;
         }
@@ -2604,6 +3230,217 @@ void LOAPlugin::OnFunctionCall(
     }
 }
 
+// ---------------- Refresh driver ----------------
+// OnTimer (1 Hz) prepares every flight a list or tag showed recently: one online-controller
+// snapshot and runway poll per refresh, then per flight the FP-edit check, the match and the
+// tag bundles. OnGetTagItem then only copies out; it prepares a flight itself only when the
+// driver has not seen it yet. A bundle is re-rendered only when its inputs changed, items
+// of it were invalidated, or it would outlive kTagBundleTtlMs before the next refresh.
+// All of this draws from one compute budget per refresh. Invalidated flights are queued by
+// urgency (assumed first, then soonest sector exit); whatever does not fit keeps showing its
+// last good value, dimmed, until a later refresh gets to it.
+
+static const ULONGLONG kRefreshIntervalMs = 1000ULL;
+static const ULONGLONG kVisibleFlightWindowMs = 5000ULL;
+// A bundle older than this is rendered again even with unchanged inputs (predictions move)
+static const ULONGLONG kTagBundleTtlMs = 2000ULL;
+
+namespace {
+    struct RefreshWorkItem {
+        FlightState* flight;
+        EuroScopePlugIn::CFlightPlan fp;
+        TagInputs inputs;
+        int tier;        // 0 = invalidated + assumed, 1 = invalidated, 2 = routine refresh
+        int exitMinutes; // INT_MAX if unknown
+        ULONGLONG frameTs;
+        uint32_t resetContexts;  // bundles rendered again from scratch
+        uint32_t fillContexts;   // bundles that only lack invalidated items
+    };
+
+    static long long ElapsedUs(std::chrono::steady_clock::time_point t0)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
+}
+
+void LOAPlugin::SetRefreshBudget(int ms)
+{
+    refreshBudgetMs = (std::max)(0, ms);
+    char buf[16];
+    sprintf_s(buf, sizeof(buf), "%d", refreshBudgetMs);
+    SaveDataToSettings("RefreshBudgetMs", "LOA plugin compute budget per refresh (ms)", buf);
+}
+
+void LOAPlugin::BeginRefresh(ULONGLONG nowMs)
+{
+    lastRefreshMs = nowMs;
+    refreshSpentUs = 0;
+    currentFrameOnlineControllers = GetOnlineControllersCached();
+
+    // Poll once per refresh instead of inside every matcher call.
+    // The poll remains throttled internally, but keeping it here avoids sector-file scans
+    // from being triggered by tag render paths.
+    PollActiveRunwaysIfNeeded();
+}
+
+void LOAPlugin::PrepareFlightFrame(FlightState& flight, const EuroScopePlugIn::CFlightPlan& fp, ULONGLONG nowMs)
+{
+    PerAircraftFrameData& frame = flight.frame;
+    frame.callsign        = flight.callsign;
+    frame.clearedAltitude = fp.GetClearedAltitude();
+    frame.finalAltitude   = fp.GetFinalAltitude();
+
+    // Detect FP edits (origin/dest/route) and invalidate per-callsign caches immediately.
+    {
+        const auto& fpd = fp.GetFlightPlanData();
+        frame.origin      = fpd.GetOrigin();
+        frame.destination = fpd.GetDestination();
+
+        const bool destinationChanged = (flight.hasLastDestination &&
+            _stricmp(flight.lastDestination.c_str(), frame.destination.c_str()) != 0);
+        flight.lastDestination = frame.destination;
+        flight.hasLastDestination = true;
+
+        // Incremental FNV-1a hash (avoid building a large concatenated string)
+        unsigned long long h = 1469598103934665603ULL;
+        auto fnv_feed = [&](const std::string& s) {
+            for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
+            };
+        fnv_feed(frame.origin);
+        fnv_feed("|");
+        fnv_feed(frame.destination);
+        fnv_feed("|");
+        for (const auto& rp : GetCachedRoutePoints(fp)) {
+            fnv_feed(rp);
+            fnv_feed(",");
+        }
+
+        if (!flight.hasRouteSignature || flight.routeSignature != h) {
+            flight.routeSignature = h;
+            flight.hasRouteSignature = true;
+            CleanupCache(flight.callsign); // force recompute match & route caches
+            if (destinationChanged) {
+                flight.activeHandoffTarget.clear();
+            }
+        }
+    }
+
+    GetCachedRouteSet(fp); // warm for the matcher
+    const LOAEntry* match = MatchLoaEntry(fp);
+    if (match && !IsLoaEntryPointerValid(match)) {
+        match = nullptr;
+    }
+    frame.matchedEntry = match;
+    flight.frameTs = nowMs;
+}
+
+void LOAPlugin::FillTagBundle(FlightState& flight, TagBundle& bundle,
+    const EuroScopePlugIn::CFlightPlan& fp, const EuroScopePlugIn::CRadarTarget& rt,
+    const TagInputs& inputs, ULONGLONG nowMs)
+{
+    if (bundle.validMask == 0) {
+        bundle.ts = nowMs;
+        bundle.inputs = inputs;
+    }
+
+    // Altitudes can change between refreshes; they are part of the bundle inputs anyway
+    flight.frame.clearedAltitude = inputs.clearedAlt;
+    flight.frame.finalAltitude   = inputs.finalAlt;
+
+    for (int slot = 0; slot < RENDER_SLOT_COUNT; ++slot) {
+        const uint32_t bit = 1u << slot;
+        if (!(bundle.usedMask & bit) || (bundle.validMask & bit)) continue;
+
+        // None of the items sets a font size; EuroScope keeps its own
+        TagBundleItem& item = bundle.items[slot];
+        item.text[0] = '\0';
+        item.colorCode = TAG_COLOR_DEFAULT;
+        item.rgb = 0;
+        double fontSize = 0.0;
+        RenderTagItem(flight, fp, rt, ItemCodeForRenderSlot(slot), 0,
+            item.text, &item.colorCode, &item.rgb, &fontSize);
+        bundle.validMask |= bit;
+        bundle.renderedMask |= bit;
+    }
+}
+
+void LOAPlugin::RefreshVisibleFlights(ULONGLONG nowMs)
+{
+    if (reloading) return;
+    LOA_TRACE_SCOPE("refresh", "RefreshVisibleFlights");
+
+    BeginRefresh(nowMs);
+    CheckForOwnershipChange(); // no-op unless the online set changed
+
+    std::vector<RefreshWorkItem> queue;
+    for (EuroScopePlugIn::CFlightPlan fp = FlightPlanSelectFirst(); fp.IsValid(); fp = FlightPlanSelectNext(fp)) {
+        // Only flights a list or tag asked for recently; FindFlightState never creates records
+        FlightState* flight = FindFlightState(fp.GetCallsign());
+        if (!flight || nowMs - flight->lastTagMs > kVisibleFlightWindowMs) continue;
+        const int state = fp.GetState();
+        if (!IsLOARelevantState(state)) continue;
+        if (_stricmp(fp.GetFlightPlanData().GetPlanType(), "I") != 0) continue;
+
+        RefreshWorkItem w{ flight, fp, TagInputs::Read(fp, sectorControlVersion), 2, INT_MAX, flight->frameTs, 0, 0 };
+
+        bool invalidated = (flight->frameTs == 0);
+        for (uint32_t c = 0; c < TAG_CONTEXT_COUNT; ++c) {
+            const TagBundle& b = flight->bundles[c];
+            if (b.usedMask == 0) continue;
+            const bool changed = (b.ts == 0 || !(b.inputs == w.inputs));
+            // Would expire before the next refresh (half an interval of timer slack)
+            const bool expiring = nowMs - b.ts + kRefreshIntervalMs / 2 >= kTagBundleTtlMs;
+            if (changed) invalidated = true;
+            if (changed || expiring) w.resetContexts |= 1u << c;
+            else if (b.usedMask & ~b.validMask) w.fillContexts |= 1u << c;
+        }
+        if (w.resetContexts == 0 && w.fillContexts == 0) continue; // every bundle is current
+        if (invalidated || w.fillContexts != 0) {
+            w.tier = (state == EuroScopePlugIn::FLIGHT_PLAN_STATE_ASSUMED) ? 0 : 1;
+        }
+        const int exitMinutes = fp.GetSectorExitMinutes();
+        if (exitMinutes >= 0) w.exitMinutes = exitMinutes;
+
+        queue.push_back(w);
+    }
+
+    std::sort(queue.begin(), queue.end(), [](const RefreshWorkItem& a, const RefreshWorkItem& b) {
+        if (a.tier != b.tier) return a.tier < b.tier;
+        if (a.exitMinutes != b.exitMinutes) return a.exitMinutes < b.exitMinutes;
+        return a.frameTs < b.frameTs;
+        });
+
+    int deferred = 0;
+    for (RefreshWorkItem& w : queue) {
+        if (!HasRefreshBudget()) {
+            ++deferred;
+            continue;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        PrepareFlightFrame(*w.flight, w.fp, nowMs);
+
+        for (uint32_t c = 0; c < TAG_CONTEXT_COUNT; ++c) {
+            const uint32_t bit = 1u << c;
+            if (!((w.resetContexts | w.fillContexts) & bit)) continue;
+            TagBundle& bundle = w.flight->bundles[c];
+
+            EuroScopePlugIn::CRadarTarget rt;
+            if (c == TAG_CONTEXT_RADAR) {
+                rt = w.fp.GetCorrelatedRadarTarget();
+                if (!rt.IsValid()) continue;
+            }
+
+            // A reset re-renders every item; a fill renders only the invalidated ones
+            if (w.resetContexts & bit) bundle.validMask = 0;
+            FillTagBundle(*w.flight, bundle, w.fp, rt, w.inputs, nowMs);
+        }
+        refreshSpentUs += ElapsedUs(t0);
+    }
+    lastRefreshDeferred = deferred;
+}
+
 void LOAPlugin::OnGetTagItem(
     EuroScopePlugIn::CFlightPlan flightPlan,
     EuroScopePlugIn::CRadarTarget radarTarget,
@@ -2614,130 +3451,117 @@ void LOAPlugin::OnGetTagItem(
     COLORREF* pRGB,
     double* pFontSize)
 {
-    const std::string callsign = flightPlan.GetCallsign();
-    int clearedAltitude = flightPlan.GetClearedAltitude();
-    int finalAltitude = flightPlan.GetFinalAltitude();
-
-    // ---------- MICRO-CACHE: reuse last render for this callsign+itemCode (<= 750–1000 ms) ----------
+    LOA_STATS_SCOPE(LOA_STAT_GET_TAG_ITEM);
     ULONGLONG now = GetTickCount64();
 
     static ULONGLONG lastCachePruneMs = 0;
     if (now - lastCachePruneMs > 30000ULL) {
-        plugin.PrunePerformanceCaches(now);
+        PrunePerformanceCaches(now);
         lastCachePruneMs = now;
     }
 
-    const int sectorControlVersion = plugin.sectorControlVersion;
-    const std::string coordPt = flightPlan.GetExitCoordinationPointName();
-    const int coordPtSt = flightPlan.GetExitCoordinationNameState();
-    const int coordAlt = flightPlan.GetExitCoordinationAltitude();
-    const int coordAltSt = flightPlan.GetExitCoordinationAltitudeState();
-
-    // Hot-path: avoid std::to_string temporary allocations
-    std::string renderKey;
-    renderKey.reserve(callsign.size() + 8);
-    renderKey.append(callsign);
-    renderKey.push_back(':');
-    char itemBuf[16] = { 0 };
-    _itoa_s(itemCode, itemBuf, 10);
-    renderKey.append(itemBuf);
-    auto itRC = renderCache.find(renderKey);
-    if (itRC != renderCache.end()) {
-        const RenderItemCache& rc = itRC->second;
-        const bool fresh = (now - rc.ts) <= 2000;
-        const bool sameInputs =
-            rc.clearedAlt == clearedAltitude &&
-            rc.finalAlt == finalAltitude &&
-            rc.coordAlt == coordAlt &&
-            rc.coordAltState == coordAltSt &&
-            rc.coordPoint == coordPt &&
-            rc.coordPointState == coordPtSt &&
-            rc.sectorVersion == sectorControlVersion;
-
-        if (fresh && sameInputs) {
-            strncpy_s(sItemString, 16, rc.text, _TRUNCATE);
-            if (pColorCode) *pColorCode = rc.colorCode;
-            if (pRGB)       *pRGB = rc.rgb;
+    // Hot-path: the flight's record is resolved once; its tag bundles are inline, so a hit allocates nothing
+    FlightState& flight = GetFlightState(flightPlan);
+    flight.lastTagMs = now;
+
+    const TagInputs inputs = TagInputs::Read(flightPlan, sectorControlVersion);
+    const int renderSlot = RenderSlotForItemCode(itemCode);
+    TagBundle* bundle = nullptr;
+    if (renderSlot >= 0) {
+        // List entries and radar tags render differently (and may show other items): one bundle each
+        bundle = &flight.bundles[radarTarget.IsValid() ? TAG_CONTEXT_RADAR : TAG_CONTEXT_LIST];
+        const uint32_t bit = 1u << renderSlot;
+        bundle->usedMask |= bit;
+
+        const bool sameInputs = (bundle->inputs == inputs);
+        const bool fresh = bundle->ts != 0 && (now - bundle->ts) <= kTagBundleTtlMs && sameInputs;
+        if (!fresh) {
+            if (bundle->ts != 0) {
+                LOA_CACHE_INVALIDATE(LOA_CACHE_TAG_BUNDLE, sameInputs ? LOA_INVAL_TTL : LOA_INVAL_FLIGHT_PLAN);
+            }
+            bundle->validMask = 0; // re-render every item of this context below
+        }
+        else if (bundle->validMask & bit) {
+            LOA_CACHE_HIT(LOA_CACHE_TAG_BUNDLE);
+            const TagBundleItem& item = bundle->items[renderSlot];
+            strncpy_s(sItemString, 16, item.text, _TRUNCATE);
+            if (pColorCode) *pColorCode = item.colorCode;
+            if (pRGB)       *pRGB = item.rgb;
             // 🚫 Do NOT touch pFontSize here – let EuroScope keep its own font.
             return;
         }
-    }
-    // -----------------------------------------------------------------------------------------------
-
-    // Precompute and cache route + controller data per frame (gate 250 -> 750 ms)
-    if (callsign != plugin.currentFrameCallsign || now - plugin.currentFrameTimestamp > 1000) {
-        plugin.currentFrameCallsign = callsign;
-        plugin.currentFrameTimestamp = now;
-        plugin.currentFrameOnlineControllers = plugin.GetOnlineControllersCached();
-
-        // Poll once per current-frame refresh instead of inside every matcher call.
-        // The poll remains throttled internally, but keeping it here avoids sector-file scans
-        // from being triggered by secondary tag render paths.
-        plugin.PollActiveRunwaysIfNeeded();
 
-        plugin.currentFrameRoutePoints = plugin.GetCachedRoutePoints(flightPlan);
-
-        // Detect FP edits (origin/dest/route) and invalidate per-callsign caches immediately.
-        {
-            const auto& fpd = flightPlan.GetFlightPlanData();
-            plugin.currentFrameRenderData.origin      = fpd.GetOrigin();
-            plugin.currentFrameRenderData.destination = fpd.GetDestination();
-
-            auto itDest = lastDestinationByCallsign.find(callsign);
-            const bool destinationChanged = (itDest != lastDestinationByCallsign.end() &&
-                _stricmp(itDest->second.c_str(), plugin.currentFrameRenderData.destination.c_str()) != 0);
-            lastDestinationByCallsign[callsign] = plugin.currentFrameRenderData.destination;
-
-            // Incremental FNV-1a hash (avoid building a large concatenated string)
-            unsigned long long h = 1469598103934665603ULL;
-            auto fnv_feed = [&](const std::string& s) {
-                for (unsigned char c : s) { h ^= c; h *= 1099511628211ull; }
-                };
-            fnv_feed(plugin.currentFrameRenderData.origin);
-            fnv_feed("|");
-            fnv_feed(plugin.currentFrameRenderData.destination);
-            fnv_feed("|");
-            for (const auto& rp : plugin.currentFrameRoutePoints) {
-                fnv_feed(rp);
-                fnv_feed(",");
-            }
-
-            auto itSig = plugin.routeSignature.find(callsign);
-            if (itSig == plugin.routeSignature.end() || itSig->second != h) {
-                plugin.routeSignature[callsign] = h;
-                plugin.CleanupCache(callsign); // force recompute match & route caches
-                if (destinationChanged) {
-                    plugin.coordinationStates.erase(callsign);
-                    plugin.activeHandoffTargets.erase(callsign);
-                }
+        // Over this refresh's budget: show the last good value (dimmed once its inputs changed)
+        // and leave the recompute to the refresh driver's queue
+        if (!HasRefreshBudget()) {
+            if (bundle->renderedMask & bit) {
+                LOA_CACHE_STALE_HIT(LOA_CACHE_TAG_BUNDLE);
+                const TagBundleItem& item = bundle->items[renderSlot];
+                const bool stale = (bundle->ts == 0 || !sameInputs);
+                strncpy_s(sItemString, 16, item.text, _TRUNCATE);
+                if (pColorCode) *pColorCode = stale ? TAG_COLOR_NON_CONCERNED : item.colorCode;
+                if (pRGB)       *pRGB = item.rgb;
+            }
+            else {
+                LOA_CACHE_MISS(LOA_CACHE_TAG_BUNDLE);
+                sItemString[0] = '\0';
             }
+            return;
         }
+        LOA_CACHE_MISS(LOA_CACHE_TAG_BUNDLE);
+    }
+    // -----------------------------------------------------------------------------------------------
 
-        plugin.currentFrameRouteSet = plugin.GetCachedRouteSet(flightPlan);
-        plugin.currentFrameMatchedEntry = MatchLoaEntry(flightPlan, plugin.currentFrameOnlineControllers);
-        if (plugin.currentFrameMatchedEntry && !plugin.IsLoaEntryPointerValid(plugin.currentFrameMatchedEntry)) {
-            plugin.currentFrameMatchedEntry = nullptr;
-        }
+    // Normally the refresh driver has prepared this flight; cover flights it has not seen yet
+    if (now - lastRefreshMs > 2 * kRefreshIntervalMs) {
+        BeginRefresh(now);
     }
+    const auto t0 = std::chrono::steady_clock::now();
+    if (flight.frameTs == 0 || now - flight.frameTs > 2 * kRefreshIntervalMs) {
+        PrepareFlightFrame(flight, flightPlan, now);
+    }
+
+    if (!bundle) {
+        flight.frame.clearedAltitude = inputs.clearedAlt;
+        flight.frame.finalAltitude   = inputs.finalAlt;
+        RenderTagItem(flight, flightPlan, radarTarget, itemCode, tagData, sItemString, pColorCode, pRGB, pFontSize);
+        refreshSpentUs += ElapsedUs(t0);
+        return;
+    }
+
+    FillTagBundle(flight, *bundle, flightPlan, radarTarget, inputs, now);
+    refreshSpentUs += ElapsedUs(t0);
 
-    plugin.currentFrameRenderData.callsign        = callsign;
-    plugin.currentFrameRenderData.clearedAltitude = clearedAltitude;
-    plugin.currentFrameRenderData.finalAltitude   = finalAltitude;
-    plugin.currentFrameRenderData.matchedEntry    = plugin.currentFrameMatchedEntry;
+    const TagBundleItem& item = bundle->items[renderSlot];
+    strncpy_s(sItemString, 16, item.text, _TRUNCATE);
+    if (pColorCode) *pColorCode = item.colorCode;
+    if (pRGB)       *pRGB = item.rgb;
+}
 
+void LOAPlugin::RenderTagItem(
+    FlightState& flight,
+    EuroScopePlugIn::CFlightPlan flightPlan,
+    EuroScopePlugIn::CRadarTarget radarTarget,
+    int itemCode,
+    int tagData,
+    char sItemString[16],
+    int* pColorCode,
+    COLORREF* pRGB,
+    double* pFontSize)
+{
     // ---- Render selected tag item
     switch (itemCode)
     {
     case 1996:
-        RenderXFLTagItem(flightPlan, radarTarget, tagData, sItemString, pColorCode, pRGB, pFontSize, plugin.currentFrameRenderData);
+        RenderXFLTagItem(flightPlan, radarTarget, tagData, sItemString, pColorCode, pRGB, pFontSize, flight.frame);
         break;
 
     case 2000:
-        RenderXFLDetailedTagItem(flightPlan, radarTarget, tagData, sItemString, pColorCode, pRGB, pFontSize, plugin.currentFrameRenderData);
+        RenderXFLDetailedTagItem(flightPlan, radarTarget, tagData, sItemString, pColorCode, pRGB, pFontSize, flight.frame);
         break;
 
     case 1997:
-        RenderCOPTagItem(flightPlan, radarTarget, tagData, sItemString, pColorCode, pRGB, pFontSize, plugin.currentFrameRenderData);
+        RenderCOPTagItem(flightPlan, radarTarget, tagData, sItemString, pColorCode, pRGB, pFontSize, flight.frame);
         break;
 
     case 2001:
@@ -2756,9 +3580,8 @@ void LOAPlugin::OnGetTagItem(
                 *pColorCode = TAG_COLOR_REDUNDANT;
             }
 
-            auto itH = activeHandoffTargets.find(cs);
-            if (itH != activeHandoffTargets.end()) {
-                strncpy_s(sItemString, 16, itH->second.c_str(), _TRUNCATE);
+            if (!flight.activeHandoffTarget.empty()) {
+                strncpy_s(sItemString, 16, flight.activeHandoffTarget.c_str(), _TRUNCATE);
                 break;  // Don't process LOA logic
             }
 
@@ -2792,7 +3615,7 @@ void LOAPlugin::OnGetTagItem(
 
         bool displayed = false;
 
-        const LOAEntry* match = plugin.currentFrameMatchedEntry;
+        const LOAEntry* match = flight.frame.matchedEntry;
         const bool hasLoa = (match && !match->nextSectors.empty());
 
         if (hasLoa) {
@@ -2800,7 +3623,7 @@ void LOAPlugin::OnGetTagItem(
             const std::string& next = match->nextSectors.front();
 
             // Resolve who actually controls that LOA next sector via ownership/priority
-            std::string station = plugin.GetIndicatedNextSectorStation(next);
+            std::string station = GetIndicatedNextSectorStation(next);
 
             if (!station.empty()) {
                 strncpy_s(sItemString, 16, station.c_str(), _TRUNCATE);
@@ -2815,15 +3638,15 @@ void LOAPlugin::OnGetTagItem(
         }
 
         // 2) NO LOA MATCH → ES PREDICTION
-        std::string predicted = plugin.GetPredictedNextController(flightPlan);
+        std::string predicted = GetPredictedNextController(flightPlan);
 
         if (!predicted.empty()) {
             const auto& online =
-                !plugin.currentFrameOnlineControllers.empty()
-                ? plugin.currentFrameOnlineControllers
-                : plugin.GetOnlineControllersCached();
+                !currentFrameOnlineControllers.empty()
+                ? currentFrameOnlineControllers
+                : GetOnlineControllersCached();
 
-            std::string myId = plugin.ControllerMyself().GetPositionId();
+            std::string myId = ControllerMyself().GetPositionId();
 
             if (_stricmp(predicted.c_str(), myId.c_str()) != 0 &&
                 online.count(predicted) > 0)
@@ -2848,38 +3671,21 @@ void LOAPlugin::OnGetTagItem(
         break;
     }
 
-    // ---------- Store result in micro-cache for this callsign+itemCode ----------
-    {
-        RenderItemCache rc;
-        rc.ts = now;
-        strncpy_s(rc.text, 16, sItemString ? sItemString : "", _TRUNCATE);
-        rc.colorCode = pColorCode ? *pColorCode : 0;
-        rc.rgb = pRGB ? *pRGB : 0;
-        // 🚫 Do NOT store / use any font size anymore.
-        rc.fontSize = 0.0;
-        rc.clearedAlt = clearedAltitude;
-        rc.finalAlt = finalAltitude;
-        rc.coordAlt = coordAlt;
-        rc.coordAltState = coordAltSt;
-        rc.coordPoint = coordPt;
-        rc.coordPointState = coordPtSt;
-        rc.sectorVersion = sectorControlVersion;
-        renderCache[renderKey] = rc;
-    }
 }
 
 const std::unordered_set<std::string>& LOAPlugin::GetCachedRouteSet(const EuroScopePlugIn::CFlightPlan& fp) {
     static std::unordered_set<std::string> empty;
     if (!fp.IsValid()) return empty;
 
-    const std::string callsign = fp.GetCallsign();
+    FlightState& fs = GetFlightState(fp);
     const ULONGLONG now = GetTickCount64();
 
-    auto itTs = routeSetCacheTime.find(callsign);
-    if (itTs != routeSetCacheTime.end() && now - itTs->second < 5000) {
-        auto itSet = routeSetCache.find(callsign);
-        if (itSet != routeSetCache.end()) return itSet->second;
+    if (fs.routeSetTs != 0 && now - fs.routeSetTs < 5000) {
+        LOA_CACHE_HIT(LOA_CACHE_ROUTE_SET);
+        return fs.routeSet;
     }
+    if (fs.routeSetTs != 0) LOA_CACHE_INVALIDATE(LOA_CACHE_ROUTE_SET, LOA_INVAL_TTL);
+    else LOA_CACHE_MISS(LOA_CACHE_ROUTE_SET);
 
     const auto& pts = GetCachedRoutePoints(fp);
 
@@ -2892,10 +3698,9 @@ const std::unordered_set<std::string>& LOAPlugin::GetCachedRouteSet(const EuroSc
         s.insert(std::move(p));
     }
 
-    routeSetCacheTime[callsign] = now;
-    auto& resultSet = routeSetCache[callsign];
-    resultSet = std::move(s);
-    return resultSet;
+    fs.routeSetTs = now;
+    fs.routeSet = std::move(s);
+    return fs.routeSet;
 }
 
 // =============================
@@ -2903,7 +3708,7 @@ const std::unordered_set<std::string>& LOAPlugin::GetCachedRouteSet(const EuroSc
 // =============================
 bool LOAPlugin::TryGetLoaMatch(
     const EuroScopePlugIn::CFlightPlan& fp,
-    const std::unordered_set<std::string>& onlineControllers,
+    const std::unordered_set<std::string>& /*onlineControllers*/,
     const std::vector<std::string>& /*routePoints*/,
     LoaMatchResult& out)
 {
@@ -2913,8 +3718,7 @@ bool LOAPlugin::TryGetLoaMatch(
     if (!IsLOARelevantState(fp.GetState())) return false;
 
     // Use existing matcher (cached internally by callsign + sectorControlVersion)
-    const auto& online = onlineControllers.empty() ? currentFrameOnlineControllers : onlineControllers;
-    const LOAEntry* m = MatchLoaEntry(fp, online);
+    const LOAEntry* m = MatchLoaEntry(fp);
     if (m) {
         out.entry = m;
         // Heuristic: if originAirports present -> departure; else destination.
@@ -2928,5 +3732,3 @@ bool LOAPlugin::TryGetLoaMatch(
     }
     return false;
 }
-
-LOAPlugin plugin;
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "EuroScopePlugIn.h"
+#include "LoaArena.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -10,6 +11,12 @@
 #include <array>
 #include <cstdint>
 #include <utility>
+#include <functional>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 using namespace EuroScopePlugIn;
 
@@ -26,8 +33,47 @@ enum class LOAListKind : uint8_t {
 	DepartureFallback = 4
 };
 
+// Which constraints an entry has (LoaHotEntry::constraintFlags), so the matcher can skip
+// gates without touching the entry's containers
+enum LoaConstraintFlag : uint16_t {
+	LOA_HAS_ORIGIN          = 1 << 0,
+	LOA_HAS_DESTINATION     = 1 << 1,
+	LOA_HAS_RUNWAYS         = 1 << 2,
+	LOA_HAS_NEXT_SECTORS    = 1 << 3,
+	LOA_HAS_WAYPOINTS       = 1 << 4,
+	LOA_HAS_NOT_VIA         = 1 << 5,
+	LOA_HAS_ENTER_VOLUMES   = 1 << 6,
+	LOA_HAS_FROM_VOLUMES    = 1 << 7,
+	LOA_HAS_TO_VOLUMES      = 1 << 8,
+	LOA_HAS_EXCLUDE_DEST    = 1 << 9,
+	LOA_HAS_EXCLUDE_ORIGIN  = 1 << 10,
+	LOA_HAS_VOLUMES = LOA_HAS_ENTER_VOLUMES | LOA_HAS_FROM_VOLUMES | LOA_HAS_TO_VOLUMES
+};
+
+// One bit per interned runway designator (RunwayTable::InternRunway)
+struct RunwayMask {
+	uint64_t w[4] = { 0, 0, 0, 0 };
+
+	void Set(uint16_t bit) { w[bit >> 6] |= 1ULL << (bit & 63); }
+	bool Any() const { return (w[0] | w[1] | w[2] | w[3]) != 0; }
+	bool Intersects(const RunwayMask& o) const {
+		return ((w[0] & o.w[0]) | (w[1] & o.w[1]) | (w[2] & o.w[2]) | (w[3] & o.w[3])) != 0;
+	}
+	bool operator==(const RunwayMask& o) const {
+		return w[0] == o.w[0] && w[1] == o.w[1] && w[2] == o.w[2] && w[3] == o.w[3];
+	}
+	bool operator!=(const RunwayMask& o) const { return !(*this == o); }
+};
+
+// What the matcher scans per candidate lives in LoaHotEntry; the containers below are
+// read only by gates that actually run, and the text fields at the end only for rendering.
 struct LOAEntry {
-	std::vector<std::string> sectors;
+	LOAListKind listKind = LOAListKind::Unknown;
+	int xfl = 0;               // numeric FL (legacy)
+	int minAltitudeFt = 0;  // For fallbackLoas: minimum altitude (e.g. 24500 for FL245)
+	bool requireNextSectorOnline = false;
+
+	// --- gate data ---
 	std::vector<std::string> waypoints;
 	// If ANY of these waypoints are present in the route, this LOA must NOT match.
 	// (Waypoints are normalized to lowercase at JSON load, same as "waypoints".)
@@ -38,20 +84,11 @@ struct LOAEntry {
 	std::vector<std::string> predictedEnterVolumes;
 	std::vector<std::string> predictedFromVolumes;
 	std::vector<std::string> predictedToVolumes;
-	std::vector<std::string> originAirports;
-	std::vector<std::string> destinationAirports;
-	std::vector<std::string> nextSectors;
 	// Runway constraints (matches EuroScope Active Airports/Runways selection)
 	// - For Departure lists: compared against active DEP runways at ORIGIN airport
 	// - For Destination lists: compared against active ARR runways at DESTINATION airport
-	// If empty: no runway constraint.
-	std::vector<std::string> runways;
-	int xfl = 0;               // numeric FL (legacy)
-	std::string xflText;       // optional text value (e.g. "23R", "230-")
-	std::string copText = "COPX";
-	bool requireNextSectorOnline = false;
-	int minAltitudeFt = 0;  // For fallbackLoas: minimum altitude (e.g. 24500 for FL245)
-	LOAListKind listKind = LOAListKind::Unknown;
+	// Interned at load (RunwayTable::InternRunway); only read with LOA_HAS_RUNWAYS.
+	RunwayMask runwayMask;
 
 	// ✅ NEW: Optimized airport matching
 	std::unordered_set<std::string> originAirportSet;
@@ -60,13 +97,44 @@ struct LOAEntry {
 	std::vector<std::string> destinationAirportPrefixes;
 
 	// --- Exclusions ---
-	std::vector<std::string> excludeDestinationAirports;
 	std::unordered_set<std::string> excludeDestinationAirportSet;
 	std::vector<std::string> excludeDestinationAirportPrefixes;
-
-	std::vector<std::string> excludeOriginAirports;
 	std::unordered_set<std::string> excludeOriginAirportSet;
 	std::vector<std::string> excludeOriginAirportPrefixes;
+
+	// --- cold: as written in the JSON, for rendering and diagnostics ---
+	std::vector<std::string> sectors;
+	std::vector<std::string> nextSectors;
+	std::vector<std::string> originAirports;
+	std::vector<std::string> destinationAirports;
+	std::vector<std::string> excludeDestinationAirports;
+	std::vector<std::string> excludeOriginAirports;
+	std::vector<std::string> runways;   // if empty: no runway constraint
+	std::string xflText;       // optional text value (e.g. "23R", "230-")
+	std::string copText = "COPX";
+};
+
+// Packed matcher view of one LOAEntry, built at load. loadedSectorLoaHot[sector][i]
+// describes loadedSectorLoas[sector][i]; the match lists and waypoint index point here,
+// so phase filters, pruning, scoring and the flag-only gates never leave this array.
+// 'entry' is dereferenced only by gates whose constraint flag is set, and for the winner.
+struct LoaHotEntry {
+	const LOAEntry* entry = nullptr;
+	// Source + next sectors as SectorMaskBit()s; a match depending on this entry is
+	// invalidated when any of these sectors changes controller
+	uint64_t sectorMask = 0;
+	// sectors / nextSectors as SectorGraph IDs (kNone if not in sector_ownership.json),
+	// stored in loadedLoaArena
+	LoaIdSpan sectorIds;
+	LoaIdSpan nextSectorIds;
+	// Score terms that do not depend on who is online (LoaStaticScore); the matcher adds
+	// only the next-sector term per flight
+	int staticScore = 0;
+	int xfl = 0;
+	uint16_t constraintFlags = 0;   // LoaConstraintFlag bits (LoaConstraintFlagsOf)
+	LOAListKind listKind = LOAListKind::Unknown;
+	// Copy of entry->runwayMask; past the first cache line, read only with LOA_HAS_RUNWAYS
+	RunwayMask runwayMask;
 };
 
 // Helper result for LOA matching
@@ -76,6 +144,175 @@ struct LoaMatchResult {
 	LoaMatchResult() : entry(NULL), isDeparture(false) {}
 };
 
+// =============================
+// Planar projection (volumes + predicted trajectories)
+// =============================
+// Local conformal (stereographic) plane anchored at the FIR centroid.
+// Coordinates are whole metres east/north of the anchor, clamped to +-(2^30 - 1), so
+// cross products of coordinate differences, and so orientation tests, are exact in int64.
+struct PlanarPoint {
+	int32_t x = 0;
+	int32_t y = 0;
+};
+
+struct PlanarProjection {
+	double anchorLat = 0.0;
+	double anchorLon = 0.0;
+	double sinAnchorLat = 0.0;
+	double cosAnchorLat = 1.0;
+	bool valid = false;
+
+	void SetAnchor(double lat, double lon);
+	PlanarPoint Project(double lat, double lon) const;
+};
+
+// Exact integer predicates over projected points (PlanarGeometry.cpp)
+int OrientPlanar(const PlanarPoint& a, const PlanarPoint& b, const PlanarPoint& c);
+bool PointInPlanarPolygon(const PlanarPoint& p, const std::vector<PlanarPoint>& poly);
+bool SegmentIntersectsPlanarPolygon(const PlanarPoint& a, const PlanarPoint& b, const std::vector<PlanarPoint>& poly);
+
+// Uniform grid over projected bounding boxes. Cells keep item indices in one flat
+// array (CSR layout), so a point query is two divisions and one contiguous range.
+class PlanarGridIndex {
+public:
+	void Build(const std::vector<PlanarPoint>& boundsMin, const std::vector<PlanarPoint>& boundsMax, int32_t cellSizeM);
+	void Clear();
+	bool Empty() const { return items.empty(); }
+	size_t FootprintBytes() const { return (cellStart.capacity() + items.capacity()) * sizeof(uint32_t); }
+
+	// Candidate item indices for the cell containing p (outCount = 0 if none)
+	const uint32_t* Query(const PlanarPoint& p, size_t& outCount) const;
+
+private:
+	int64_t originX = 0;
+	int64_t originY = 0;
+	int64_t cellSize = 1;
+	int32_t cols = 0;
+	int32_t rows = 0;
+	std::vector<uint32_t> cellStart; // cols*rows + 1 offsets into items
+	std::vector<uint32_t> items;
+};
+
+// Closed altitude intervals [lowerFt, upperFt]. Sorted interval edges split the axis
+// into elementary slabs (each edge itself, then the open span up to the next edge);
+// every slab lists the intervals covering it, so a query is one binary search.
+class AltitudeBandIndex {
+public:
+	void Build(const std::vector<double>& lowerFt, const std::vector<double>& upperFt);
+	void Clear();
+	bool Empty() const { return items.empty(); }
+	size_t FootprintBytes() const {
+		return edges.capacity() * sizeof(double) + (slabStart.capacity() + items.capacity()) * sizeof(uint32_t);
+	}
+
+	// Interval indices covering altFt (outCount = 0 if none)
+	const uint32_t* Query(double altFt, size_t& outCount) const;
+	// Interval indices overlapping [loFt, hiFt], sorted and unique (out is overwritten)
+	void QueryRange(double loFt, double hiFt, std::vector<uint32_t>& out) const;
+
+private:
+	std::vector<double> edges;       // sorted, unique
+	std::vector<uint32_t> slabStart; // (2 * edges - 1) + 1 offsets into items
+	std::vector<uint32_t> items;
+};
+
+// =============================
+// Compiled sector ownership graph (SectorGraph.cpp)
+// =============================
+// sector_ownership.json compiled to dense IDs: one ID space for sectors and stations,
+// an ownership bit matrix and a priority rank matrix, so gates compare integers
+// instead of scanning string lists.
+class SectorGraph {
+public:
+	static const uint16_t kNone = 0xFFFF;
+	static const uint8_t kUnranked = 0xFF;
+
+	void Build(const std::unordered_map<std::string, std::vector<std::string>>& ownership,
+		const std::unordered_map<std::string, std::vector<std::string>>& priority);
+	void Clear();
+
+	size_t Size() const { return names.size(); }
+	uint16_t Id(const std::string& name) const; // case-insensitive; kNone if unknown
+	const std::string& Name(uint16_t id) const { return names[id]; }
+
+	// Sector has an "ownership" entry (a defined sector)
+	bool IsDefined(uint16_t sector) const { return sector < Size() && defined[sector] != 0; }
+	// station's ownership list contains sector
+	bool Owns(uint16_t station, uint16_t sector) const {
+		if (station >= Size() || sector >= Size()) return false;
+		return (ownBits[station * wordsPerRow + (sector >> 6)] >> (sector & 63)) & 1ULL;
+	}
+	// Position of station in sector's priority list (0 = first), kUnranked if absent
+	uint8_t Rank(uint16_t sector, uint16_t station) const {
+		if (sector >= Size() || station >= Size()) return kUnranked;
+		return rank[(size_t)sector * Size() + station];
+	}
+	// a is listed before b in sector's priority list
+	bool Outranks(uint16_t sector, uint16_t a, uint16_t b) const {
+		const uint8_t ra = Rank(sector, a);
+		const uint8_t rb = Rank(sector, b);
+		return ra != kUnranked && rb != kUnranked && ra < rb;
+	}
+	const std::vector<uint16_t>& Priority(uint16_t sector) const { return priority[sector]; }
+	size_t FootprintBytes() const;
+
+private:
+	uint16_t Intern(const std::string& name);
+
+	std::unordered_map<std::string, uint16_t> ids; // LoaNameKey -> ID
+	std::vector<std::string> names;
+	std::vector<uint8_t> defined;
+	std::vector<uint64_t> ownBits;                 // Size() rows of wordsPerRow words
+	size_t wordsPerRow = 0;
+	std::vector<uint8_t> rank;                     // Size() x Size()
+	std::vector<std::vector<uint16_t>> priority;
+};
+
+// =============================
+// Active runway table (RunwayTable.cpp)
+// =============================
+// Airports and runway designators from the sector file (and LOA runway lists) interned
+// to dense IDs. Active runway ends are one RunwayMask per airport and direction, so a
+// runway poll compares bitsets and reports exactly which airports changed.
+
+class RunwayTable {
+public:
+	static const uint16_t kNone = 0xFFFF;
+	static const uint16_t kMaxRunways = 256;   // RunwayMask width
+
+	// Change flags per airport reported by CommitScan
+	enum : uint8_t { CHANGED_DEP = 1, CHANGED_ARR = 2 };
+
+	// Keyed by LoaNameKey; kNone if empty (or the runway table is full)
+	uint16_t InternAirport(const char* icao);
+	uint16_t InternRunway(const char* designator);
+	uint16_t AirportId(const std::string& icao) const;      // kNone if unknown
+
+	size_t AirportCount() const { return airportNames.size(); }
+	const std::string& AirportName(uint16_t id) const { return airportNames[id]; }
+
+	// Active runway ends at airport (empty mask for kNone / nothing selected)
+	const RunwayMask& Active(uint16_t airport, bool departure) const;
+
+	// Sector file poll: BeginScan, MarkActive per active runway end, then CommitScan
+	// publishes the new selection and fills changed[airport] with CHANGED_* flags.
+	// Returns true if any airport changed.
+	void BeginScan();
+	void MarkActive(uint16_t airport, uint16_t runway, bool departure);
+	bool CommitScan(std::vector<uint8_t>& changed);
+
+	size_t FootprintBytes() const;
+
+private:
+	std::unordered_map<std::string, uint16_t> airportIds;  // LoaNameKey(ICAO) -> ID
+	std::vector<std::string> airportNames;
+	std::unordered_map<std::string, uint16_t> runwayIds;   // LoaNameKey(designator) -> ID
+	std::vector<std::string> runwayNames;
+
+	std::vector<RunwayMask> activeDep, activeArr;          // by airport ID
+	std::vector<RunwayMask> scanDep, scanArr;              // reused by every poll
+};
+
 // =============================
 // Custom Volume (user-defined sector volume)
 // =============================
@@ -83,8 +320,77 @@ struct CustomVolume {
 	std::string id;
 	double lowerFt = 0.0;
 	double upperFt = 999999.0;
-	// polygon points as [lat, lon] in decimal degrees
-	std::vector<std::pair<double, double>> polygon;
+	// polygon vertices, projected once at load (see PlanarProjection)
+	std::vector<PlanarPoint> polygon;
+	PlanarPoint boundsMin;
+	PlanarPoint boundsMax;
+};
+
+// All volumes from volumes.json, stored densely so per-match results can be indexed
+// by position. The altitude index prunes stacked volumes before any geometry runs.
+struct CustomVolumeSet {
+	std::vector<CustomVolume> volumes;
+	std::unordered_map<std::string, uint32_t> indexById;
+	AltitudeBandIndex bands;
+	uint32_t generation = 0; // bumps with every published reload
+
+	void Clear() { volumes.clear(); indexById.clear(); bands.Clear(); }
+	int Find(const std::string& id) const {
+		auto it = indexById.find(id);
+		return (it != indexById.end()) ? (int)it->second : -1;
+	}
+};
+
+// Published volume sets are never modified. Readers take a reference for the duration
+// of one match, so a reload can swap in a new set without waiting for them.
+typedef std::shared_ptr<const CustomVolumeSet> CustomVolumeSnapshot;
+
+// Hand-off slot between the reload worker and the UI thread
+struct VolumeReloadResult {
+	std::mutex lock;
+	bool ready = false;
+	CustomVolumeSnapshot snapshot;      // null if the file could not be loaded
+	PlanarProjection projection;
+	std::vector<std::string> messages;  // shown on the UI thread
+};
+
+// Stations that came online / went offline in one update of the online set
+struct OnlineControllersDiff {
+	uint64_t version = 0;
+	std::vector<std::string> added;
+	std::vector<std::string> removed;
+};
+
+// Handoff target at one position: the controller's callsign and primary frequency,
+// formatted when it changes ("123.450"). An empty callsign means nobody is online there.
+struct ControllerContact {
+	std::string callsign;
+	std::string frequency;
+	double frequencyMhz = 0.0;
+};
+
+// Online controllers by interned position ID (ControllerDirectory.cpp), maintained from
+// OnControllerPositionUpdate/OnControllerDisconnect. Popup rows and handoffs are lookups.
+// IDs are never reused; a position that went offline keeps its slot with no callsign.
+class ControllerDirectory {
+public:
+	static const uint16_t kNone = 0xFFFF;
+
+	uint16_t Intern(const char* positionId);            // LoaNameKey; kNone if empty
+	uint16_t Id(const std::string& positionId) const;   // kNone if never seen
+	size_t Size() const { return names.size(); }
+
+	ControllerContact& At(uint16_t id) { return contacts[id]; }
+	// Online controller at the position (case-insensitive), nullptr if none
+	const ControllerContact* Find(const std::string& positionId) const;
+	void Remove(uint16_t id) { contacts[id].callsign.clear(); }
+
+	size_t FootprintBytes() const;
+
+private:
+	std::unordered_map<std::string, uint16_t> ids;      // LoaNameKey(position) -> ID
+	std::vector<std::string> names;
+	std::vector<ControllerContact> contacts;
 };
 
 struct PerAircraftFrameData {
@@ -112,9 +418,22 @@ struct CoordinationInfo {
 // =============================
 // Sector polygons for route-based next sectors
 // =============================
+// Sector-file element -> sector mapping from sector_ownership.json ("sectorPolygons").
+// The sector file carries no vertical limits, so an element is only indexed when its
+// floor and ceiling are configured here.
+struct SectorPolygonSource {
+	std::string sectorId;        // e.g. "ALR", "HAM"
+	double lowerFt = 0.0;
+	double upperFt = 0.0;
+};
+
 struct SectorPolygon {
 	std::string sectorId;        // e.g. "ALR", "HAM"
-	std::vector<CPosition> pts;  // polygon vertices from sector file
+	double lowerFt = 0.0;        // covers [lowerFt, upperFt)
+	double upperFt = 0.0;
+	std::vector<PlanarPoint> pts;  // polygon vertices from sector file, projected at load
+	PlanarPoint boundsMin;
+	PlanarPoint boundsMax;
 };
 
 // =============================
@@ -148,20 +467,91 @@ namespace FunctionIds {
 // =============================
 // Global LOA Containers
 // =============================
-extern std::vector<LOAEntry> destinationLoas;
-extern std::vector<LOAEntry> departureLoas;
-extern std::vector<LOAEntry> destinationFallbackLoas;
-extern std::vector<LOAEntry> departureFallbackLoas;
+// Entries are stored per source sector (loadedSectorLoas, stable after load) with a parallel
+// hot array (loadedSectorLoaHot); the active lists point into the hot arrays of source
+// sectors that are not outranked by an online controller.
+extern std::vector<const LoaHotEntry*> destinationLoas;
+extern std::vector<const LoaHotEntry*> departureLoas;
+extern std::vector<const LoaHotEntry*> destinationFallbackLoas;
+extern std::vector<const LoaHotEntry*> departureFallbackLoas;
 extern std::map<std::string, std::vector<LOAEntry>> loadedSectorLoas;
+extern std::map<std::string, std::vector<LoaHotEntry>> loadedSectorLoaHot;
+// Trivially destructible per-load data of loadedSectorLoas (ID arrays); retired with it
+extern MonotonicArena loadedLoaArena;
+
+// Tables of a previous position, handed to the retire worker to be freed
+struct RetiredLoaTables {
+	std::map<std::string, std::vector<LOAEntry>> tables;
+	std::map<std::string, std::vector<LoaHotEntry>> hot;
+	MonotonicArena arena;
+};
 
-extern std::unordered_map<std::string, std::string> controllerFrequencies;
 extern std::unordered_map<int, std::pair<std::string, EuroScopePlugIn::CFlightPlan>> handoffTargets;
 
 // =============================
 // Match Function
 // =============================
 bool EqualsIgnoreCase(const std::string& a, const std::string& b);
-const LOAEntry* MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp, const std::unordered_set<std::string>& onlineControllers);
+// Predicted altitude in feet; EuroScope reports some as flight levels
+double ToAltFeet(int altOrLevel);
+int LoaStaticScore(const LOAEntry& e);
+uint16_t LoaConstraintFlagsOf(const LOAEntry& e);
+// Index bucket order: static score descending, ties by address (a total order, so
+// merged buckets put duplicates next to each other)
+inline bool LoaScoreOrder(const LoaHotEntry* a, const LoaHotEntry* b) {
+	if (a->staticScore != b->staticScore) return a->staticScore > b->staticScore;
+	return std::less<const LoaHotEntry*>()(a, b);
+}
+
+// Candidate gates of the main match phases. Exclusions always run first (they decide the
+// flight's sector dependency mask); the gates below are pure and ANDed, so their order
+// only changes cost. LoaGateTable orders them by measured cost per rejection.
+enum LoaGate : uint8_t {
+	LOA_GATE_SOURCE_SUPPRESSED,
+	LOA_GATE_NEXT_SECTOR,
+	LOA_GATE_AIRPORT,
+	LOA_GATE_RUNWAY,
+	LOA_GATE_FINAL_ALTITUDE,
+	LOA_GATE_VOLUMES,
+	LOA_GATE_NOT_VIA,
+	LOA_GATE_WAYPOINTS,
+	LOA_GATE_COUNT
+};
+
+struct LoaGateCounters {
+	uint64_t evaluations = 0;
+	uint64_t rejections = 0;
+	uint64_t sampledNs = 0;   // time of sampled evaluations only
+	uint64_t samples = 0;
+};
+
+struct LoaGateTable {
+	static const uint32_t kSampleEvery = 16;      // time 1 in N chain evaluations
+	static const uint32_t kReorderEvery = 4096;   // chain evaluations between reorders
+
+	std::array<uint8_t, LOA_GATE_COUNT> order;    // current evaluation order
+	std::array<LoaGateCounters, LOA_GATE_COUNT> counters;
+	uint32_t chainEvaluations = 0;
+	uint32_t reorders = 0;
+
+	// Differential check: every match is repeated with the gates in FixedOrder() and the
+	// winners compared
+	bool verify = false;
+	uint64_t verifyChecks = 0;
+	uint64_t verifyMismatches = 0;
+	std::string lastMismatch;   // callsign of the most recent mismatch
+
+	LoaGateTable() { Reset(); }
+	void Reset();
+	void Reorder();
+	// Folds one match's counters in; reorders every kReorderEvery chain evaluations
+	void Record(const std::array<LoaGateCounters, LOA_GATE_COUNT>& matchCounts, uint32_t chains);
+	void RecordVerify(bool same, const char* callsign);
+	static const std::array<uint8_t, LOA_GATE_COUNT>& FixedOrder();
+	// Expected cost (ns) spent on this gate per rejection; lower runs earlier
+	double CostPerRejection(uint8_t gate) const;
+	static const char* Name(uint8_t gate);
+};
 
 // =============================
 // Tag Render Functions
@@ -196,6 +586,166 @@ void RenderCOPTagItem(
 	double* pFontSize,
 	const PerAircraftFrameData& ctx);
 
+// =============================
+// Per-flight state (FlightState.cpp)
+// =============================
+// One slot per registered tag item for the render micro-cache
+enum RenderItemSlot : uint32_t {
+	RENDER_SLOT_XFL = 0,
+	RENDER_SLOT_XFL_DETAILED,
+	RENDER_SLOT_NEXT_SECTOR,
+	RENDER_SLOT_COP,
+	RENDER_SLOT_COUNT
+};
+int RenderSlotForItemCode(int itemCode); // -1 if the item is not cached
+int ItemCodeForRenderSlot(int slot);
+
+// Rendered value of one tag item.
+struct TagBundleItem {
+	char text[16] = { 0 };
+	int colorCode = 0;
+	COLORREF rgb = 0;
+};
+
+// All tag items of one flight in one display context (list or radar tag), rendered in
+// one pass from one set of inputs. The first item a refresh asks for fills every item
+// the context has shown before; its siblings copy out of the bundle.
+// All fields are inline and fixed-size: hits and refreshes never allocate.
+enum TagContext : uint32_t {
+	TAG_CONTEXT_LIST = 0,
+	TAG_CONTEXT_RADAR,
+	TAG_CONTEXT_COUNT
+};
+
+// Inputs that affect tag rendering (cheap and small); a bundle is reused only while they hold
+struct TagInputs {
+	int clearedAlt = 0, finalAlt = 0, coordAlt = 0, coordAltState = 0;
+	char coordPoint[16] = { 0 };
+	int coordPointState = 0;
+	int sectorVersion = 0;
+
+	static TagInputs Read(const EuroScopePlugIn::CFlightPlan& fp, int sectorVersion);
+	bool operator==(const TagInputs& o) const;
+};
+
+struct TagBundle {
+	ULONGLONG ts = 0;       // 0 = empty
+	uint32_t usedMask = 0;  // slots this context has displayed (learned)
+	uint32_t validMask = 0; // slots rendered into this bundle
+	uint32_t renderedMask = 0; // slots holding a last good value (kept across invalidation)
+	TagBundleItem items[RENDER_SLOT_COUNT];
+	TagInputs inputs;
+};
+
+// COP tag: learned baseline / pending request values (TagCOP.cpp)
+struct CopHeuristicState {
+	std::string baselineValue;
+	std::string pendingValue;
+	bool hasBaseline = false;
+	bool pendingActive = false;
+};
+
+// XFL tag: learned baseline / pending request values (TagXFL.cpp)
+struct XflCoordHeuristicState {
+	int baselineValue = 0;
+	int pendingValue = 0;
+	bool hasBaseline = false;
+	bool pendingActive = false;
+};
+
+// Everything the plugin remembers about one flight, in one record.
+// The callsign is resolved to a slot once per callback; the whole record is
+// released on OnFlightPlanDisconnect.
+struct FlightState {
+	std::string callsign;
+	ULONGLONG lastSeenMs = 0;
+	ULONGLONG lastTagMs = 0;               // last OnGetTagItem; scopes the refresh driver
+
+	// Refresh frame (PrepareFlightFrame): match + FP data shared by all tag items
+	PerAircraftFrameData frame;
+	ULONGLONG frameTs = 0;                 // 0 = not prepared
+
+	// Route cache (GetCachedRoutePoints / GetCachedRouteSet)
+	std::vector<std::string> routePoints;
+	ULONGLONG routeTs = 0;                 // 0 = not cached
+	std::unordered_set<std::string> routeSet;
+	ULONGLONG routeSetTs = 0;              // 0 = not cached
+	unsigned long long routeSignature = 0; // hash of origin|dest|route to detect FP edits
+	bool hasRouteSignature = false;
+	std::string lastDestination;
+	bool hasLastDestination = false;
+
+	// Match cache (MatchLoaEntry): 5s + sectorControlVersion + volume generation
+	const LOAEntry* matchedEntry = nullptr;
+	ULONGLONG matchTs = 0;                 // 0 = not cached
+	int matchVersion = 0;
+	uint32_t matchVolumeGeneration = 0;
+	uint64_t matchSectorMask = 0;          // sectors whose control the cached match depended on
+	uint16_t matchDepRunwayAirport = RunwayTable::kNone; // airports whose active runways it depended on
+	uint16_t matchArrRunwayAirport = RunwayTable::kNone;
+
+	// Coordination
+	CoordinationInfo coordination;         // heuristic cache for COP/XFL tag rendering
+	std::string activeHandoffTarget;       // sector we initiated a handoff to (empty = none)
+	CopHeuristicState cop;
+	XflCoordHeuristicState xfl;
+
+	// Tag render bundles, one per display context
+	TagBundle bundles[TAG_CONTEXT_COUNT];
+
+	void ResetMatch() {
+		matchedEntry = nullptr; matchTs = 0;
+		frame.matchedEntry = nullptr; frameTs = 0;
+	}
+	void ResetRoute() {
+		routePoints.clear(); routeTs = 0;
+		routeSet.clear(); routeSetTs = 0;
+	}
+	void ResetRender() {
+		// Items keep their text: over budget they are served as stale until re-rendered
+		for (TagBundle& b : bundles) { b.ts = 0; b.validMask = 0; }
+	}
+};
+
+// Stable slot map of FlightState records. Slots live in a deque (addresses never move),
+// freed slots are reused, and callsign -> slot is an open-addressing table hashed
+// straight from the C string.
+class FlightStateTable {
+public:
+	static const uint32_t kInvalid = 0xFFFFFFFFu;
+
+	uint32_t Find(const char* callsign) const;
+	uint32_t Acquire(const char* callsign);   // find or create
+	void Release(uint32_t slot);              // frees the whole record
+
+	FlightState& operator[](uint32_t slot) { return slots[slot]; }
+	const FlightState& operator[](uint32_t slot) const { return slots[slot]; }
+	bool InUse(uint32_t slot) const { return slot < inUse.size() && inUse[slot] != 0; }
+
+	template <typename Fn>
+	void ForEach(Fn fn) {
+		for (uint32_t i = 0; i < (uint32_t)slots.size(); ++i) {
+			if (inUse[i]) fn(i, slots[i]);
+		}
+	}
+
+	size_t Size() const { return live; }
+	size_t Capacity() const { return slots.size(); }
+	size_t FootprintBytes() const;            // records + owned heap, estimated from capacities
+	size_t IndexBytes() const;                // callsign table and slot bookkeeping only
+
+private:
+	void Rehash(size_t newCapacity);
+	size_t Home(uint32_t hash) const { return hash & (table.size() - 1); }
+
+	std::deque<FlightState> slots;
+	std::vector<uint8_t> inUse;
+	std::vector<uint32_t> hashes;     // slot -> hash of callsign
+	std::vector<uint32_t> freeSlots;
+	std::vector<uint32_t> table;      // linear probing, kInvalid = empty
+	size_t live = 0;
+};
+
 // =============================
 // LOAPlugin Class
 // =============================
@@ -211,8 +761,15 @@ public:
 
 	LOAPlugin();
 	virtual ~LOAPlugin();
+	// Joins the background workers and stops tracing; EuroScopePlugInExit calls it before
+	// the plugin is deleted. The destructor never joins: without Shutdown() it may run
+	// during process exit, under the loader lock.
+	void Shutdown();
 
 	virtual void OnControllerPositionUpdate(EuroScopePlugIn::CController Controller);
+	virtual void OnControllerDisconnect(EuroScopePlugIn::CController Controller) override;
+	virtual void OnTimer(int Counter) override;
+	virtual bool OnCompileCommand(const char* sCommandLine) override;
 	virtual void RequestRefreshRadarScreen() {}
 
 	// Active Airports/Runways integration (like vSID):
@@ -221,7 +778,10 @@ public:
 	virtual void OnAirportRunwayActivityChanged() override;
 
 	void UpdateActiveRunwaysFromSectorFile();
-	bool MatchesActiveRunway(const std::string& airportIcao, bool isDeparture, const std::vector<std::string>& allowedRunways) const;
+	// airport is a RunwayTable ID (kNone: not in the sector file, so nothing is active)
+	bool MatchesActiveRunway(uint16_t airport, bool isDeparture, const RunwayMask& allowedRunways) const {
+		return runwayTable.Active(airport, isDeparture).Intersects(allowedRunways);
+	}
 
 	// NEW: handle tag functions & popup selections
 	virtual void OnFunctionCall(
@@ -252,22 +812,26 @@ public:
 	// Returns controlling station ID for `nextSector` if someone online owns it via ownership/priority.
 	std::string GetIndicatedNextSectorStation(const std::string& nextSector);
 
-	// Cached active runways per airport (from sector file runway elements)
-	// Key: airport ICAO (e.g. "EDDH"), Values: runway ends (e.g. "05", "23", "09L")
-	std::unordered_map<std::string, std::unordered_set<std::string>> activeDepRunwaysByAirport;
-	std::unordered_map<std::string, std::unordered_set<std::string>> activeArrRunwaysByAirport;
+	// Active runways per airport (from sector file runway elements), as bitsets
+	// over interned runway designators (e.g. "05", "23", "09L")
+	RunwayTable runwayTable;
+	std::vector<uint8_t> runwayChanges;    // per airport, RunwayTable::CHANGED_* of the last poll
 	ULONGLONG lastActiveRunwayRefreshMs = 0;
 
 	// Polling support: some EuroScope builds don't reliably call OnAirportRunwayActivityChanged.
 	// We therefore poll runway activity flags periodically and invalidate caches when they change.
 	ULONGLONG lastRunwayPollMs = 0;
-	unsigned long long activeRunwayFingerprint = 0ULL;
 
 	void PollActiveRunwaysIfNeeded();
-	void InvalidateLoaCachesForRunwayChange();
+	void InvalidateLoaCachesForRunwayChange(bool newAirports);
 
 	std::string GetPredictedNextController(const EuroScopePlugIn::CFlightPlan& fp);
 
+	// Predicted controlling stations along the trajectory, in order, consecutive repeats removed.
+	// Uses the local sector polygon index (one sweep over the predictions); falls back to
+	// EuroScope's per-point controller lookup when the sector file gave no usable polygons.
+	std::vector<std::string> GetPredictedControllerSequence(const EuroScopePlugIn::CFlightPlan& fp);
+
 	// LOAPlugin.h
 	std::vector<std::string> BuildHybridPredictedSectorList(
 		const EuroScopePlugIn::CFlightPlan& fp,
@@ -277,67 +841,84 @@ public:
 	const std::unordered_set<std::string>& GetOnlineControllersCached();  // ✅ 5-second cache accessor
 
 	// In class LOAPlugin (LOAPlugin.h)
-	std::unordered_map<std::string, std::vector<const LOAEntry*>> indexByWaypoint;
+	std::unordered_map<std::string, std::vector<const LoaHotEntry*>> indexByWaypoint;
 	std::unordered_map<std::string, std::vector<const LOAEntry*>> indexByNextSector;
 	// O(1) pointer validity check - rebuilt after every LoadLOAsFromJSON
 	std::unordered_set<const LOAEntry*> validLoaEntryPtrs;
 
 	std::atomic<bool> reloading{ false };
 
-	// In class LOAPlugin:
-	ULONGLONG startTick = 0;
-	ULONGLONG coldStartUntil = 0;     // e.g., start + 5000 ms
-	bool      coldStartActive = true;
-
 	// LOA CACHE
-	// --- per-callsign render microcache (500–1000 ms) ---
-	struct RenderItemCache {
-		ULONGLONG ts = 0;
-		char text[16] = { 0 };
-		int colorCode = 0;
-		COLORREF rgb = 0;
-		double fontSize = 0.0;
-		// signature of inputs that affect rendering (cheap and small)
-		int clearedAlt = 0, finalAlt = 0, coordAlt = 0, coordAltState = 0;
-		std::string coordPoint;
-		int coordPointState = 0;
-		int sectorVersion = 0;
+	// --- per-flight state (route/match/coordination/render caches) ---
+	FlightStateTable flightStates;
+	uint32_t lastFlightStateSlot = FlightStateTable::kInvalid; // memo: one hash per callback
+	FlightState& GetFlightState(const EuroScopePlugIn::CFlightPlan& fp);
+	FlightState* FindFlightState(const std::string& callsign);
+	void InvalidateRenderItem(const std::string& callsign, int itemCode);
+
+	enum FlightStateReset : unsigned {
+		FS_RESET_MATCH = 1u << 0,
+		FS_RESET_ROUTE = 1u << 1,
+		FS_RESET_ROUTE_SIGNATURE = 1u << 2,
+		FS_RESET_COORDINATION = 1u << 3,
+		FS_RESET_RENDER = 1u << 4,
+		FS_RESET_LAST_DESTINATION = 1u << 5
 	};
+	void ResetFlightStates(unsigned what);
+	void ReportFlightStateMemory();
+	void ReportMemory();
+	// High-water mark of flightStates.FootprintBytes(), sampled by PrunePerformanceCaches
+	size_t flightStatePeakBytes = 0;
+	size_t flightStatePeakLive = 0;
+	// Best LOA for the flight, cached per flight (FlightState match fields); in LoaMatcher.cpp
+	const LOAEntry* MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp);
+	LoaGateTable loaGates;
+	void ReportLoaGates();
+	void ReportLoaStats();
+	void ReportLoaCacheStats();
+	bool DumpLoaStats(const std::string& path);
 
-	std::unordered_map<std::string, RenderItemCache> renderCache; // key = callsign + ":" + std::to_string(itemCode)
-
-	PerAircraftFrameData currentFrameRenderData;
 	const std::vector<std::string>& GetCachedRoutePoints(const EuroScopePlugIn::CFlightPlan& fp);
 	const std::unordered_set<std::string>& GetCachedRouteSet(const EuroScopePlugIn::CFlightPlan& fp);
-	std::unordered_map<std::string, const LOAEntry*> matchedLOACache;
-	std::unordered_map<std::string, std::vector<std::string>> routeCache;
-	std::unordered_map<std::string, ULONGLONG> routeSetCacheTime;
-	std::unordered_map<std::string, ULONGLONG> matchTimestamps;
-	std::unordered_map<std::string, int> matchVersions;
-	std::unordered_map<std::string, std::unordered_set<std::string>> routeSetCache;
-	std::unordered_map<std::string, ULONGLONG> routeCacheTime;
-	std::unordered_set<std::string> currentFrameRouteSet;
 	int sectorControlVersion = 0;
 
+	// --- refresh driver (OnTimer, 1 Hz): per-refresh snapshot + per-flight frames/bundles ---
 	std::unordered_set<std::string> currentFrameOnlineControllers;
-	std::vector<std::string> currentFrameRoutePoints;
-	std::string currentFrameCallsign;
-	ULONGLONG currentFrameTimestamp = 0;
-	const LOAEntry* currentFrameMatchedEntry = nullptr;
-
-	// Track which sector we initiated a handoff to (per callsign)
-	std::unordered_map<std::string, std::string> activeHandoffTargets;
+	ULONGLONG lastRefreshMs = 0;
+	// Compute budget per refresh (0 = unlimited); flights over budget show their last value
+	int refreshBudgetMs = 25;
+	long long refreshSpentUs = 0;
+	int lastRefreshDeferred = 0;
+	bool HasRefreshBudget() const { return refreshBudgetMs <= 0 || refreshSpentUs < refreshBudgetMs * 1000LL; }
+	void SetRefreshBudget(int ms);
+	void BeginRefresh(ULONGLONG nowMs);
+	void RefreshVisibleFlights(ULONGLONG nowMs);
+	void PrepareFlightFrame(FlightState& flight, const EuroScopePlugIn::CFlightPlan& fp, ULONGLONG nowMs);
+	void FillTagBundle(FlightState& flight, TagBundle& bundle,
+		const EuroScopePlugIn::CFlightPlan& fp, const EuroScopePlugIn::CRadarTarget& rt,
+		const TagInputs& inputs, ULONGLONG nowMs);
 
-	// Coordination heuristic cache for COP/XFL tag rendering
-	std::unordered_map<std::string, CoordinationInfo> coordinationStates;
 
 	void CleanupCache(const std::string& callsign);
 	void PrunePerformanceCaches(ULONGLONG nowMs);
 	virtual void OnFlightPlanStateChange(EuroScopePlugIn::CFlightPlan fp);
+	virtual void OnFlightPlanDisconnect(EuroScopePlugIn::CFlightPlan fp) override;
 	virtual void OnFlightPlanCoordinationStateChange(EuroScopePlugIn::CFlightPlan fp, int coordinationType, int newState);
 
 	void CheckForOwnershipChange();
 
+	// Renders one tag item uncached into sItemString/pColorCode/pRGB (needs flight.frame prepared)
+	void RenderTagItem(
+		FlightState& flight,
+		EuroScopePlugIn::CFlightPlan flightPlan,
+		EuroScopePlugIn::CRadarTarget radarTarget,
+		int itemCode,
+		int tagData,
+		char sItemString[16],
+		int* pColorCode,
+		COLORREF* pRGB,
+		double* pFontSize);
+
 	virtual void OnGetTagItem(
 		EuroScopePlugIn::CFlightPlan flightPlan,
 		EuroScopePlugIn::CRadarTarget radarTarget,
@@ -351,9 +932,12 @@ public:
 
 	// ✅ Sector Ownership Logic
 	void LoadSectorOwnership();
-	std::string ResolveControllingSector(const std::string& sector, const std::unordered_set<std::string>& onlineControllers);
+	std::string ResolveControllingSector(const std::string& sector);
+	uint16_t ResolveControllingStationId(uint16_t sector);
 	std::unordered_map<std::string, std::vector<std::string>> sectorOwnership; // e.g., "ALR": ["HEI", "EID"]
 	std::unordered_map<std::string, std::vector<std::string>> sectorPriority;  // e.g., "FRI": ["EID", "ALR"]
+	std::unordered_map<std::string, SectorPolygonSource> sectorPolygonSources; // LoaNameKey(element name) -> sector + limits
+	SectorGraph sectorGraph;                                                   // compiled from the two maps above
 
 	// Sectors that contributed AOR destinations (e.g., HAM, HAMW)
 	std::unordered_set<std::string> aorHostSectors;
@@ -375,49 +959,116 @@ public:
 
 	// ---------------- Custom Volumes (volumes.json) ----------------
 	void LoadVolumesFromJSON(const std::string& volumesPath);
-	const std::unordered_map<std::string, CustomVolume>& GetCustomVolumes() const { return customVolumes; }
+	// Rebuilds volumes.json on a worker thread; the result is published from OnTimer
+	bool RequestVolumesReload();
+	CustomVolumeSnapshot GetCustomVolumes() const { return std::atomic_load(&customVolumes); }
+	const PlanarProjection& GetPlanarProjection() const { return planarProjection; }
 private:
 	std::string loadedSector;
-	std::unordered_map<std::string, std::string> lastDestinationByCallsign;
 	void LoadLOAsFromJSON();
 
-	void OnControllerDisconnect(const EuroScopePlugIn::CController& controller);
-
 	void OnGetControllerList();
 
-	bool IsPointInsidePolygon(const CPosition& p,
-		const std::vector<CPosition>& poly) const;
+	bool IsPointInsidePolygon(const PlanarPoint& p,
+		const SectorPolygon& poly) const;
 
-	std::unordered_map<std::string, CustomVolume> customVolumes;
+	// ---------------- Sector-file polygon index ----------------
+	// Built once per sector-file load from the ARTCC / airspace elements named in sectorPolygonSources.
+	void EnsureSectorPolygonIndex();
+	void LoadSectorPolygonsFromSectorFile();
+	const SectorPolygon* FindSectorPolygonAt(const PlanarPoint& p, double altFt) const;
+
+	std::vector<SectorPolygon> sectorPolygons;
+	PlanarGridIndex sectorPolygonGrid;
+	unsigned long long sectorFileFingerprint = 0ULL;
+	ULONGLONG lastSectorFileCheckMs = 0;
+	bool sectorPolygonsDirty = true;
+
+	// Current volume set; replaced as a whole via std::atomic_store
+	CustomVolumeSnapshot customVolumes = std::make_shared<const CustomVolumeSet>();
+
+	// Anchored at the centroid of all volume vertices on the first successful load,
+	// then fixed for the session (reloads project into the same plane)
+	PlanarProjection planarProjection;
 
 	// volumes.json is global/static configuration.
-	// Load only once at startup; do NOT reload on sector switches.
+	// Load once at startup; do NOT reload on sector switches. Edits are picked up by
+	// the file poll / ".loa reload volumes" and swapped in as a new snapshot.
 	bool volumesLoadAttempted = false;
 	bool volumesLoadedOk = false;
 	std::string volumesLoadedPath;
+	unsigned long long volumesFileStamp = 0ULL;
+	ULONGLONG lastVolumesPollMs = 0;
+	uint32_t volumeGenerationCounter = 0;
+	std::shared_ptr<VolumeReloadResult> volumeReloadPending;
+	std::thread volumeReloadWorker;   // joined before the next reload and in Shutdown()
+
+	void PublishVolumesReloadIfReady();
+	void PollVolumesFileIfNeeded();
 
 	// --- Debug: watch TopSky strip annotations ---
 	bool debugWatchStripAnnotations = true; // set false to disable
 	std::unordered_map<std::string, std::array<std::string, 9>> lastStripAnn;
 	ULONGLONG lastStripScanTick = 0;
 
+	// --- Online controllers, maintained from OnControllerPositionUpdate/OnControllerDisconnect ---
 	std::unordered_set<std::string> cachedOnlineControllers;
-
-	// Online-controller snapshot generation (bumps when cached online set refreshes)
+	std::unordered_map<std::string, int> onlineStationRefs;                // position ID -> connected controllers
+	std::unordered_map<std::string, std::string> onlineStationByCallsign; // controller callsign -> position ID
+	OnlineControllersDiff lastOnlineDiff;                                   // last membership change
+	bool onlineControllersSeeded = false;
+	ControllerDirectory controllerDirectory;                                // position -> handoff target
+
+	void TrackControllerStation(const std::string& callsign, const std::string& positionId);
+	void RetainOnlineStation(const std::string& positionId, OnlineControllersDiff& diff);
+	void ReleaseOnlineStation(const std::string& positionId, OnlineControllersDiff& diff);
+	void PublishOnlineControllersDiff(OnlineControllersDiff& diff);
+	void ReconcileOnlineControllers(ULONGLONG nowMs);
+	void UpdateControllerContact(EuroScopePlugIn::CController controller);
+	void RemoveControllerContact(const std::string& callsign);
+
+	// Online-controller generation (bumps only when a station comes online or goes offline)
 	uint64_t onlineControllersVersion = 0;
 
-	// Per-generation cache for ResolveControllingSector (sector -> controlling station)
-	std::unordered_map<std::string, std::string> controllingSectorCache;
-	uint64_t controllingSectorCacheVersion = 0;
+	// --- Handoff popup (OnTimer) ---
+	bool popupPrewarmed = false;  // created on the first OnTimer, not at DLL load
+
+	// --- Per-sector LOA tables (LoadLOAsFromJSON / CheckForOwnershipChange) ---
+	std::vector<std::string> loadedSectorOrder;                       // my sector first, then owned
+	std::unordered_set<std::string> activeLoaSectors;                 // sectors whose entries are in the active lists
+	std::unordered_map<std::string, uint32_t> sectorBitIds;           // source/next sectors -> dense ID
+	std::unordered_map<std::string, std::string> trackedSectorControl; // same sectors -> station at the last check
+	uint64_t ownershipCheckVersion = 0;
+
+	uint64_t SectorMaskBit(const std::string& sector) const;
+	bool IsSectorOutranked(const std::string& sector, const std::string& mySector);
+	void SetLoaSectorActive(const std::string& sector, bool active);
+	void RebuildActiveLoaLists();
+
+	// Old tables are freed by one worker (started on first use, joined in Shutdown())
+	void RetireLoaTables();
+	void RetireLoop();
+	std::mutex retireLock;
+	std::condition_variable retireWake;
+	std::deque<std::unique_ptr<RetiredLoaTables>> retireQueue;
+	bool retireStop = false;
+	std::thread retireWorker;
+
+	// Controlling station per graph sector (kNone = nobody online), valid while resolvedValid is set;
+	// PublishOnlineControllersDiff clears only the sectors a diff can affect
+	std::vector<uint16_t> resolvedStation;
+	std::vector<uint8_t> resolvedValid;
+	std::vector<uint8_t> onlineById; // graph ID -> station online
+	void RebuildSectorGraphState();
 	// ✅ Cached online controllers
 
-	std::unordered_map<std::string, unsigned long long> routeSignature;  // hash of origin|dest|route to detect FP edits
 
 	ULONGLONG lastOwnershipRecheckTime = 0;
-	ULONGLONG lastOnlineFetchTime = 0;
+	ULONGLONG lastOnlineFetchTime = 0; // last full reconciliation scan
 };
 
 // =============================
 // Plugin Instance
 // =============================
-extern LOAPlugin plugin;
\ No newline at end of file
+// The instance registered with EuroScope (EuroScopePlugInInit); NULL outside Init/Exit
+extern LOAPlugin* pMyPlugIn;
\ No newline at end of file
@@ -17,5 +17,7 @@ EuroScopePlugInInit(EuroScopePlugIn::CPlugIn** ppPlugInInstance)
 void __declspec (dllexport)
 EuroScopePlugInExit(void)
 {
+	pMyPlugIn->Shutdown();
 	delete pMyPlugIn;
+	pMyPlugIn = NULL;
 }
\ No newline at end of file
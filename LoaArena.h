@@ -0,0 +1,90 @@
+﻿#pragma once
+
+// =============================
+// Monotonic arena for per-load LOA data
+// =============================
+// Bump allocation from fixed blocks; nothing is freed individually and Release() drops
+// every block at once. Only trivially destructible data may live here (the arena never
+// runs destructors), e.g. the sector ID arrays of LOAEntry.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class MonotonicArena {
+public:
+	static const size_t kBlockBytes = 64 * 1024;
+
+	MonotonicArena() = default;
+	MonotonicArena(MonotonicArena&& other) { *this = std::move(other); }
+	MonotonicArena& operator=(MonotonicArena&& other)
+	{
+		if (this == &other) return *this;
+		// Blocks change owner without moving, so data handed out stays where it is
+		blocks = std::move(other.blocks);
+		blockSize = other.blockSize;
+		used = other.used;
+		reserved = other.reserved;
+		other.Release();
+		return *this;
+	}
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+	void* Allocate(size_t bytes, size_t align)
+	{
+		size_t offset = (used + align - 1) & ~(align - 1);
+		if (blocks.empty() || offset + bytes > blockSize) {
+			// Oversized requests get a block of their own
+			blockSize = (bytes > kBlockBytes) ? bytes : kBlockBytes;
+			blocks.emplace_back(new char[blockSize]);
+			reserved += blockSize;
+			offset = 0;
+		}
+		used = offset + bytes;
+		return blocks.back().get() + offset;
+	}
+
+	// Copies [first, first + n) into the arena; nullptr for n == 0
+	template <typename T>
+	const T* Copy(const T* first, size_t n)
+	{
+		static_assert(std::is_trivially_destructible<T>::value && std::is_trivially_copyable<T>::value,
+			"arena data is never destroyed");
+		if (n == 0) return nullptr;
+		T* out = static_cast<T*>(Allocate(n * sizeof(T), alignof(T)));
+		std::memcpy(out, first, n * sizeof(T));
+		return out;
+	}
+
+	void Release()
+	{
+		blocks.clear();
+		blockSize = 0;
+		used = 0;
+		reserved = 0;
+	}
+
+	size_t BytesReserved() const { return reserved; }
+
+private:
+	std::vector<std::unique_ptr<char[]>> blocks;
+	size_t blockSize = 0;  // size of blocks.back()
+	size_t used = 0;       // bytes used in blocks.back()
+	size_t reserved = 0;
+};
+
+// Read-only view of an ID array in a MonotonicArena
+struct LoaIdSpan {
+	const uint16_t* ids = nullptr;
+	uint32_t count = 0;
+
+	const uint16_t* begin() const { return ids; }
+	const uint16_t* end() const { return ids + count; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+};
@@ -1,6 +1,8 @@
 ﻿#include "stdafx.h"
 #include "windows.h"
 #include "LOAPlugin.h"
+#include "LoaStats.h"
+#include "LoaTrace.h"
 #include <string>
 #include <vector>
 #include <cctype>
@@ -9,6 +11,8 @@
 #include <chrono>
 #include <algorithm>
 #include <climits>
+#include <cmath>
+#include <limits>
 
 bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
     if (a.size() != b.size()) return false;
@@ -19,202 +23,390 @@ bool EqualsIgnoreCase(const std::string& a, const std::string& b) {
 }
 
 
-static double ToAltFeet(int altOrLevel)
+double ToAltFeet(int altOrLevel)
 {
     // EuroScope may return altitude in feet or level (FL). If it's small, treat as FL.
     if (altOrLevel > 0 && altOrLevel < 1000) return (double)altOrLevel * 100.0;
     return (double)altOrLevel;
 }
 
-struct PredSampleLL {
-    double lat;
-    double lon;
-    double altFt;
+// Predicted trajectory sample, projected once per match into the volume plane
+struct PredSample {
+    PlanarPoint pos;
+    float altFt;
 };
 
-static void BuildPredSamplesLL(const EuroScopePlugIn::CFlightPlan& fp, std::vector<PredSampleLL>& out)
+static void BuildPredSamples(const EuroScopePlugIn::CFlightPlan& fp, const PlanarProjection& proj, std::vector<PredSample>& out)
 {
     out.clear();
+    if (!proj.valid) return;
     EuroScopePlugIn::CFlightPlanPositionPredictions preds = fp.GetPositionPredictions();
     const int n = preds.GetPointsNumber();
     if (n <= 0) return;
     out.reserve((size_t)n);
     for (int i = 0; i < n; ++i) {
         EuroScopePlugIn::CPosition p = preds.GetPosition(i);
-        out.push_back(PredSampleLL{ p.m_Latitude, p.m_Longitude, ToAltFeet(preds.GetAltitude(i)) });
+        PredSample s;
+        s.pos = proj.Project(p.m_Latitude, p.m_Longitude);
+        s.altFt = (float)ToAltFeet(preds.GetAltitude(i));
+        out.push_back(s);
     }
 }
 
+static bool InVolumeBounds(const PlanarPoint& p, const CustomVolume& vol)
+{
+    return p.x >= vol.boundsMin.x && p.x <= vol.boundsMax.x &&
+        p.y >= vol.boundsMin.y && p.y <= vol.boundsMax.y;
+}
 
-static bool PointInPolyLL(double lat, double lon, const std::vector<std::pair<double, double>>& poly)
+static bool SegmentMayTouchVolumeBounds(const PlanarPoint& a, const PlanarPoint& b, const CustomVolume& vol)
 {
+    if (a.x < vol.boundsMin.x && b.x < vol.boundsMin.x) return false;
+    if (a.x > vol.boundsMax.x && b.x > vol.boundsMax.x) return false;
+    if (a.y < vol.boundsMin.y && b.y < vol.boundsMin.y) return false;
+    if (a.y > vol.boundsMax.y && b.y > vol.boundsMax.y) return false;
+    return true;
+}
+
+// Entry times are fractional minutes along the prediction (sample i = minute i)
+static const double kNeverEnters = std::numeric_limits<double>::infinity();
+
+static bool InVolumeBand(double altFt, const CustomVolume& vol)
+{
+    return altFt >= vol.lowerFt && altFt <= vol.upperFt;
+}
+
+// Earliest t in [0, 1] at which a -> b is inside vol, horizontally and vertically,
+// with altitude interpolated linearly along the segment. Returns -1 if never.
+static double FirstEntryOnSegment(const PredSample& a, const PredSample& b, const CustomVolume& vol,
+    std::vector<double>& cuts)
+{
+    // Vertical: alt(t) = a.alt + t * (b.alt - a.alt) within [lowerFt, upperFt]
+    double tLo = 0.0;
+    double tHi = 1.0;
+    const double dAlt = (double)b.altFt - (double)a.altFt;
+    if (dAlt == 0.0) {
+        if (!InVolumeBand(a.altFt, vol)) return -1.0;
+    }
+    else {
+        double t1 = (vol.lowerFt - a.altFt) / dAlt;
+        double t2 = (vol.upperFt - a.altFt) / dAlt;
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > tLo) tLo = t1;
+        if (t2 < tHi) tHi = t2;
+        if (tLo > tHi) return -1.0;
+    }
+
+    if (!SegmentMayTouchVolumeBounds(a.pos, b.pos, vol)) return -1.0;
+
+    // Horizontal: split [tLo, tHi] at every edge crossing; inside/outside is constant
+    // between cuts, so one midpoint test per piece decides it.
+    // Projected coordinates are clamped to +-(2^30 - 1), so every cross product below
+    // is under 2^63 and exact in int64.
+    const int64_t dx = (int64_t)b.pos.x - a.pos.x;
+    const int64_t dy = (int64_t)b.pos.y - a.pos.y;
+
+    cuts.clear();
+    cuts.push_back(tLo);
+    cuts.push_back(tHi);
+
+    const std::vector<PlanarPoint>& poly = vol.polygon;
     const size_t n = poly.size();
-    if (n < 3) return false;
-    bool inside = false;
     for (size_t i = 0, j = n - 1; i < n; j = i++) {
-        const double yi = poly[i].first;
-        const double xi = poly[i].second;
-        const double yj = poly[j].first;
-        const double xj = poly[j].second;
+        const int64_t ex = (int64_t)poly[i].x - poly[j].x;
+        const int64_t ey = (int64_t)poly[i].y - poly[j].y;
+        const int64_t denom = dx * ey - dy * ex;
+        if (denom == 0) continue; // parallel; collinear overlap is caught by the midpoint tests
+
+        const int64_t px = (int64_t)poly[j].x - a.pos.x;
+        const int64_t py = (int64_t)poly[j].y - a.pos.y;
+        const double t = (double)(px * ey - py * ex) / (double)denom;
+        const double u = (double)(px * dy - py * dx) / (double)denom;
+        if (u < 0.0 || u > 1.0) continue;
+        if (t <= tLo || t >= tHi) continue;
+        cuts.push_back(t);
+    }
+    std::sort(cuts.begin(), cuts.end());
+
+    for (size_t k = 0; k + 1 < cuts.size(); ++k) {
+        const double t0 = cuts[k];
+        const double t1 = cuts[k + 1];
+        // Zero-length pieces only matter when the altitude window is a single instant
+        if (t1 - t0 < 1e-9 && cuts.size() > 2) continue;
+
+        const double mid = 0.5 * (t0 + t1);
+        PlanarPoint p;
+        p.x = (int32_t)std::floor((double)a.pos.x + mid * (double)dx + 0.5);
+        p.y = (int32_t)std::floor((double)a.pos.y + mid * (double)dy + 0.5);
+        if (PointInPlanarPolygon(p, poly)) return t0;
+    }
+    return -1.0;
+}
 
-        const bool intersect =
-            ((yi > lat) != (yj > lat)) &&
-            (lon < (xj - xi) * (lat - yi) / ((yj - yi) + 1e-12) + xi);
+// First entry time (fractional minutes) for every volume in one sweep over the
+// trajectory. Candidates per segment come from the altitude index over the
+// segment's altitude span, so stacked volumes it never reaches vertically are
+// skipped before any horizontal test. Segments are visited in order and each
+// yields its earliest crossing, so the first hit per volume is the entry time.
+static void ComputeVolumeEntryTimes(const std::vector<PredSample>& samples, const CustomVolumeSet& vols, std::vector<double>& out)
+{
+    const size_t nv = vols.volumes.size();
+    out.assign(nv, kNeverEnters);
 
-        if (intersect) inside = !inside;
+    const int n = (int)samples.size();
+    if (n <= 0) return;
+
+    size_t unresolved = nv;
+    std::vector<uint32_t> candidates;
+    std::vector<double> cuts;
+
+    for (int i = 0; i + 1 < n && unresolved > 0; ++i) {
+        const PredSample& s = samples[(size_t)i];
+        const PredSample& s2 = samples[(size_t)i + 1];
+
+        const double lo = (s.altFt < s2.altFt) ? s.altFt : s2.altFt;
+        const double hi = (s.altFt < s2.altFt) ? s2.altFt : s.altFt;
+        vols.bands.QueryRange(lo, hi, candidates);
+
+        for (uint32_t v : candidates) {
+            if (out[v] != kNeverEnters) continue;
+            const double t = FirstEntryOnSegment(s, s2, vols.volumes[v], cuts);
+            if (t >= 0.0) {
+                out[v] = (double)i + t;
+                --unresolved;
+            }
+        }
+    }
+
+    // Single-sample prediction (or nothing crossed before the last sample)
+    if (unresolved > 0) {
+        const PredSample& last = samples[(size_t)n - 1];
+        size_t count = 0;
+        const uint32_t* ids = vols.bands.Query(last.altFt, count);
+        for (size_t k = 0; k < count; ++k) {
+            const uint32_t v = ids[k];
+            if (out[v] != kNeverEnters) continue;
+            const CustomVolume& vol = vols.volumes[v];
+            if (InVolumeBounds(last.pos, vol) && PointInPlanarPolygon(last.pos, vol.polygon))
+                out[v] = (double)(n - 1);
+        }
     }
-    return inside;
 }
 
-static double Cross2D(double ax, double ay, double bx, double by, double cx, double cy)
+// Next-sector score terms: the first next sector with someone online decides
+static const int kScoreNextMine = -10000;
+static const int kScoreNextOutranksMe = 50;
+// Upper bound of the next-sector term; static score + this bounds any entry's score
+static const int kScoreNextMax = kScoreNextOutranksMe;
+
+int LoaStaticScore(const LOAEntry& e)
 {
-    // Cross product of AB x AC
-    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+    int score = 0;
+
+    // prefer destination over departure (fallbacks: by list)
+    if (e.listKind == LOAListKind::DestinationFallback) score += 20;
+    else if (e.listKind != LOAListKind::DepartureFallback && !e.destinationAirports.empty()) score += 20;
+
+    // small bonus if COP text present (tie-break)
+    if (!e.copText.empty()) score += 5;
+
+    // tie-break on higher XFL last
+    score += e.xfl;
+    return score;
 }
 
-static bool OnSegment2D(double ax, double ay, double bx, double by, double cx, double cy)
+uint16_t LoaConstraintFlagsOf(const LOAEntry& e)
 {
-    double minx = (ax < bx ? ax : bx);
-    double maxx = (ax > bx ? ax : bx);
-    double miny = (ay < by ? ay : by);
-    double maxy = (ay > by ? ay : by);
-    const double eps = 1e-12;
-    return (minx - eps <= cx && cx <= maxx + eps) && (miny - eps <= cy && cy <= maxy + eps);
+    uint16_t flags = 0;
+    if (!e.originAirports.empty())        flags |= LOA_HAS_ORIGIN;
+    if (!e.destinationAirports.empty())   flags |= LOA_HAS_DESTINATION;
+    if (!e.runways.empty())               flags |= LOA_HAS_RUNWAYS;
+    if (!e.nextSectors.empty())           flags |= LOA_HAS_NEXT_SECTORS;
+    if (!e.waypoints.empty())             flags |= LOA_HAS_WAYPOINTS;
+    if (!e.notViaWaypoints.empty())       flags |= LOA_HAS_NOT_VIA;
+    if (!e.predictedEnterVolumes.empty()) flags |= LOA_HAS_ENTER_VOLUMES;
+    if (!e.predictedFromVolumes.empty())  flags |= LOA_HAS_FROM_VOLUMES;
+    if (!e.predictedToVolumes.empty())    flags |= LOA_HAS_TO_VOLUMES;
+    if (!e.excludeDestinationAirports.empty() || !e.excludeDestinationAirportSet.empty() ||
+        !e.excludeDestinationAirportPrefixes.empty()) flags |= LOA_HAS_EXCLUDE_DEST;
+    if (!e.excludeOriginAirports.empty() || !e.excludeOriginAirportSet.empty() ||
+        !e.excludeOriginAirportPrefixes.empty()) flags |= LOA_HAS_EXCLUDE_ORIGIN;
+    return flags;
 }
 
-static int Orient2D(double ax, double ay, double bx, double by, double cx, double cy)
+// ---------------- Candidate gate ordering ----------------
+
+const uint32_t LoaGateTable::kSampleEvery;
+const uint32_t LoaGateTable::kReorderEvery;
+
+void LoaGateTable::Reset()
 {
-    const double v = Cross2D(ax, ay, bx, by, cx, cy);
-    const double eps = 1e-12;
-    if (v > eps) return 1;
-    if (v < -eps) return -1;
-    return 0;
+    for (uint8_t g = 0; g < LOA_GATE_COUNT; ++g) {
+        order[g] = g;
+        counters[g] = LoaGateCounters();
+    }
+    chainEvaluations = 0;
+    reorders = 0;
+    verifyChecks = 0;
+    verifyMismatches = 0;
+    lastMismatch.clear();
 }
 
-static bool SegmentsIntersect2D(double ax, double ay, double bx, double by,
-    double cx, double cy, double dx, double dy)
+double LoaGateTable::CostPerRejection(uint8_t gate) const
 {
-    const int o1 = Orient2D(ax, ay, bx, by, cx, cy);
-    const int o2 = Orient2D(ax, ay, bx, by, dx, dy);
-    const int o3 = Orient2D(cx, cy, dx, dy, ax, ay);
-    const int o4 = Orient2D(cx, cy, dx, dy, bx, by);
+    const LoaGateCounters& c = counters[gate];
+    if (c.evaluations == 0 || c.samples == 0) return HUGE_VAL; // unmeasured: keep at the back
+    const double avgNs = (double)c.sampledNs / (double)c.samples;
+    // Smoothed so a gate that never rejected still gets a finite (large) cost
+    const double rejectRate = ((double)c.rejections + 0.5) / ((double)c.evaluations + 1.0);
+    return avgNs / rejectRate;
+}
 
-    if (o1 != o2 && o3 != o4) return true;
+void LoaGateTable::Record(const std::array<LoaGateCounters, LOA_GATE_COUNT>& matchCounts, uint32_t chains)
+{
+    if (chains == 0) return;
+    for (uint8_t g = 0; g < LOA_GATE_COUNT; ++g) {
+        counters[g].evaluations += matchCounts[g].evaluations;
+        counters[g].rejections += matchCounts[g].rejections;
+        counters[g].sampledNs += matchCounts[g].sampledNs;
+        counters[g].samples += matchCounts[g].samples;
+    }
+    const uint32_t before = chainEvaluations;
+    chainEvaluations += chains;
+    if (before / kReorderEvery != chainEvaluations / kReorderEvery) Reorder();
+}
 
-    // Collinear cases
-    if (o1 == 0 && OnSegment2D(ax, ay, bx, by, cx, cy)) return true;
-    if (o2 == 0 && OnSegment2D(ax, ay, bx, by, dx, dy)) return true;
-    if (o3 == 0 && OnSegment2D(cx, cy, dx, dy, ax, ay)) return true;
-    if (o4 == 0 && OnSegment2D(cx, cy, dx, dy, bx, by)) return true;
+void LoaGateTable::RecordVerify(bool same, const char* callsign)
+{
+    ++verifyChecks;
+    if (!same) {
+        ++verifyMismatches;
+        lastMismatch = callsign;
+    }
+}
 
-    return false;
+const std::array<uint8_t, LOA_GATE_COUNT>& LoaGateTable::FixedOrder()
+{
+    static const std::array<uint8_t, LOA_GATE_COUNT> fixed = [] {
+        std::array<uint8_t, LOA_GATE_COUNT> o;
+        for (uint8_t g = 0; g < LOA_GATE_COUNT; ++g) o[g] = g;
+        return o;
+    }();
+    return fixed;
 }
 
-static bool SegmentIntersectsPolygonLL(double aLat, double aLon, double bLat, double bLon,
-    const std::vector<std::pair<double, double>>& poly)
+void LoaGateTable::Reorder()
 {
-    const size_t n = poly.size();
-    if (n < 2) return false;
-    for (size_t i = 0, j = n - 1; i < n; j = i++) {
-        const double cLat = poly[j].first, cLon = poly[j].second;
-        const double dLat = poly[i].first, dLon = poly[i].second;
-        if (SegmentsIntersect2D(aLon, aLat, bLon, bLat, cLon, cLat, dLon, dLat))
-            return true;
+    std::array<double, LOA_GATE_COUNT> cost;
+    for (uint8_t g = 0; g < LOA_GATE_COUNT; ++g) cost[g] = CostPerRejection(g);
+    std::stable_sort(order.begin(), order.end(),
+        [&](uint8_t a, uint8_t b) { return cost[a] < cost[b]; });
+
+    // Decay so the order follows the traffic mix instead of the whole session
+    for (LoaGateCounters& c : counters) {
+        c.evaluations /= 2;
+        c.rejections /= 2;
+        c.sampledNs /= 2;
+        c.samples /= 2;
     }
-    return false;
+    ++reorders;
 }
 
-static int FirstEnterMinuteVolumeFromSamplesLL(const std::vector<PredSampleLL>& samples, const CustomVolume& vol)
+const char* LoaGateTable::Name(uint8_t gate)
 {
-    const int n = (int)samples.size();
-    if (n <= 0) return INT_MAX;
-
-    // Check points + segment crossings
-    for (int i = 0; i < n; ++i) {
-        const PredSampleLL& s = samples[(size_t)i];
-        if (s.altFt >= vol.lowerFt && s.altFt <= vol.upperFt) {
-            if (PointInPolyLL(s.lat, s.lon, vol.polygon)) return i;
-        }
-        if (i + 1 < n) {
-            const PredSampleLL& s2 = samples[(size_t)i + 1];
-            // Require altitude band overlap at endpoints (simple and stable)
-            if ((s.altFt >= vol.lowerFt && s.altFt <= vol.upperFt) ||
-                (s2.altFt >= vol.lowerFt && s2.altFt <= vol.upperFt))
-            {
-                // If segment crosses polygon or enters between points, count as entry at i+1
-                if (SegmentIntersectsPolygonLL(s.lat, s.lon, s2.lat, s2.lon, vol.polygon))
-                    return i + 1;
-            }
-        }
+    switch (gate) {
+    case LOA_GATE_SOURCE_SUPPRESSED: return "source";
+    case LOA_GATE_NEXT_SECTOR:       return "next";
+    case LOA_GATE_AIRPORT:           return "airport";
+    case LOA_GATE_RUNWAY:            return "runway";
+    case LOA_GATE_FINAL_ALTITUDE:    return "rfl";
+    case LOA_GATE_VOLUMES:           return "volumes";
+    case LOA_GATE_NOT_VIA:           return "notvia";
+    case LOA_GATE_WAYPOINTS:         return "waypoints";
+    default:                         return "?";
     }
-    return INT_MAX;
 }
 
-static int FirstEnterMinuteVolume(const EuroScopePlugIn::CFlightPlan& fp, const CustomVolume& vol)
+void LOAPlugin::ReportLoaGates()
 {
-    std::vector<PredSampleLL> samples;
-    BuildPredSamplesLL(fp, samples);
-    return FirstEnterMinuteVolumeFromSamplesLL(samples, vol);
+    char buf[256];
+    sprintf_s(buf, sizeof(buf), "Gate order after %u reorders (verify %s: %llu checks, %llu mismatches)",
+        loaGates.reorders, loaGates.verify ? "on" : "off",
+        (unsigned long long)loaGates.verifyChecks, (unsigned long long)loaGates.verifyMismatches);
+    DisplayUserMessage("LOA Plugin", "Gates", buf, true, true, false, false, false);
+    if (!loaGates.lastMismatch.empty()) {
+        DisplayUserMessage("LOA Plugin", "Gates", ("Last mismatch: " + loaGates.lastMismatch).c_str(),
+            true, true, false, false, false);
+    }
+
+    for (uint8_t pos = 0; pos < LOA_GATE_COUNT; ++pos) {
+        const uint8_t g = loaGates.order[pos];
+        const LoaGateCounters& c = loaGates.counters[g];
+        const double rejectPct = c.evaluations ? 100.0 * (double)c.rejections / (double)c.evaluations : 0.0;
+        const double avgNs = c.samples ? (double)c.sampledNs / (double)c.samples : 0.0;
+        sprintf_s(buf, sizeof(buf), "%u. %-9s evals %llu, reject %.1f%%, avg %.0f ns",
+            (unsigned)pos + 1, LoaGateTable::Name(g),
+            (unsigned long long)c.evaluations, rejectPct, avgNs);
+        DisplayUserMessage("LOA Plugin", "Gates", buf, true, true, false, false, false);
+    }
 }
 
-const LOAEntry* MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp,
-    const std::unordered_set<std::string>& /*onlineControllers*/)
+const LOAEntry* LOAPlugin::MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp)
 {
-    if (!fp.IsValid() || !plugin.IsLOARelevantState(fp.GetState())) return nullptr;
+    LOA_STATS_SCOPE(LOA_STAT_MATCH);
+    if (!fp.IsValid() || !IsLOARelevantState(fp.GetState())) return nullptr;
 
     // Ensure active runway selections are up-to-date even when EuroScope doesn't fire the callback.
-    plugin.PollActiveRunwaysIfNeeded();
+    PollActiveRunwaysIfNeeded();
 
     const char* planType = fp.GetFlightPlanData().GetPlanType();
     if (_stricmp(planType, "I") != 0) return nullptr;
 
-    const std::string callsign = fp.GetCallsign();
+    LOA_TRACE_SCOPE_ARG("match", "MatchLoaEntry", fp.GetCallsign());
+
     ULONGLONG now = GetTickCount64();
 
-    // 10s cache + sectorControlVersion
-    auto tsIt = plugin.matchTimestamps.find(callsign);
-    auto verIt = plugin.matchVersions.find(callsign);
-    if (tsIt != plugin.matchTimestamps.end() &&
-        verIt != plugin.matchVersions.end() &&
-        now - tsIt->second < 5000 &&
-        verIt->second == plugin.sectorControlVersion)
-    {
-        auto matchIt = plugin.matchedLOACache.find(callsign);
-        if (matchIt != plugin.matchedLOACache.end()) {
-            return matchIt->second;
-        }
+    // Volumes are read from one snapshot for the whole call; a concurrent reload
+    // publishes a new one without affecting this match.
+    const CustomVolumeSnapshot volumeSnapshot = GetCustomVolumes();
+
+    // 5s cache + sectorControlVersion + volume generation
+    FlightState& flight = GetFlightState(fp);
+    if (flight.matchTs == 0) {
+        LOA_CACHE_MISS(LOA_CACHE_MATCH);
+    }
+    else if (now - flight.matchTs >= 5000) {
+        LOA_CACHE_INVALIDATE(LOA_CACHE_MATCH, LOA_INVAL_TTL);
+    }
+    else if (flight.matchVersion != sectorControlVersion) {
+        LOA_CACHE_INVALIDATE(LOA_CACHE_MATCH, LOA_INVAL_SECTOR_CONTROL);
+    }
+    else if (flight.matchVolumeGeneration != volumeSnapshot->generation) {
+        LOA_CACHE_INVALIDATE(LOA_CACHE_MATCH, LOA_INVAL_VOLUMES);
+    }
+    else {
+        LOA_CACHE_HIT(LOA_CACHE_MATCH);
+        return flight.matchedEntry;
     }
 
     const std::string origin = fp.GetFlightPlanData().GetOrigin();
     const std::string destination = fp.GetFlightPlanData().GetDestination();
-    const auto& routeSet = plugin.GetCachedRouteSet(fp);
+    const auto& routeSet = GetCachedRouteSet(fp);
 
-    const std::string mySector = plugin.ControllerMyself().GetPositionId();
+    const std::string mySector = ControllerMyself().GetPositionId();
 
-    // Shared caches for this match call (avoid repeated lookups)
-    std::unordered_map<std::string, std::string> resolveCache; // sectorId -> controlling sectorId
-
-    // Owned sectors as a set for fast membership checks
-    std::unordered_set<std::string> ownedSet;
-    auto ownItGlobal = plugin.sectorOwnership.find(mySector);
-    if (ownItGlobal != plugin.sectorOwnership.end()) {
-        ownedSet.reserve(ownItGlobal->second.size() * 2);
-        ownedSet.insert(ownItGlobal->second.begin(), ownItGlobal->second.end());
-    }
-
-    auto resolveController = [&](const std::string& sectorId) -> std::string {
-        auto it = resolveCache.find(sectorId);
-        if (it != resolveCache.end()) return it->second;
-        std::string actual = plugin.ResolveControllingSector(sectorId, plugin.currentFrameOnlineControllers);
-        resolveCache.emplace(sectorId, actual);
-        return actual;
+    // Ownership/priority gates compare compiled sector IDs (SectorGraph); resolutions are
+    // cached per sector by the plugin, so no per-call cache is needed
+    const SectorGraph& graph = sectorGraph;
+    const uint16_t me = graph.Id(mySector);
+    auto resolveController = [&](uint16_t sectorId) -> uint16_t {
+        return ResolveControllingStationId(sectorId);
         };
 
     // Exclusion: skip LOAs that explicitly exclude this destination
-    auto isExcludedDest = [&](const LOAEntry& e) -> bool {
-        if (!e.excludeDestinationAirports.empty() ||
-            !e.excludeDestinationAirportSet.empty() ||
-            !e.excludeDestinationAirportPrefixes.empty()) {
+    auto isExcludedDest = [&](const LoaHotEntry& h) -> bool {
+        if (h.constraintFlags & LOA_HAS_EXCLUDE_DEST) {
+            const LOAEntry& e = *h.entry;
             if (e.excludeDestinationAirportSet.count(destination) > 0) return true;
             for (const auto& pre : e.excludeDestinationAirportPrefixes) {
                 if (destination.compare(0, pre.length(), pre) == 0) return true;
@@ -222,10 +414,9 @@ const LOAEntry* MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp,
         }
         return false;
         };
-    auto isExcludedOrigin = [&](const LOAEntry& e) -> bool {
-        if (!e.excludeOriginAirports.empty() ||
-            !e.excludeOriginAirportSet.empty() ||
-            !e.excludeOriginAirportPrefixes.empty()) {
+    auto isExcludedOrigin = [&](const LoaHotEntry& h) -> bool {
+        if (h.constraintFlags & LOA_HAS_EXCLUDE_ORIGIN) {
+            const LOAEntry& e = *h.entry;
             if (e.excludeOriginAirportSet.count(origin) > 0) return true;
             for (const auto& pre : e.excludeOriginAirportPrefixes) {
                 if (origin.compare(0, pre.length(), pre) == 0) return true;
@@ -235,102 +426,96 @@ const LOAEntry* MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp,
         };
 
     // Gate by next-sector control/priority
-    auto shouldMatchLOA = [&](const std::vector<std::string>& nextSectors) -> bool {
-        for (const std::string& next : nextSectors) {
-            std::string actualController = resolveController(next);
+    auto shouldMatchLOA = [&](const LoaIdSpan& nextSectors) -> bool {
+        for (uint16_t next : nextSectors) {
+            const uint16_t actualController = resolveController(next);
+            const bool nobodyOnline = (actualController == SectorGraph::kNone);
 
-            bool nextIsDefined = plugin.sectorOwnership.find(next) != plugin.sectorOwnership.end();
-            const bool iOwnNext = (ownedSet.count(next) > 0);
+            const bool nextIsDefined = graph.IsDefined(next);
+            const bool iOwnNext = graph.Owns(me, next);
 
-            if (_stricmp(actualController.c_str(), mySector.c_str()) == 0) return false;
+            if (!nobodyOnline && actualController == me) return false;
 
             if (nextIsDefined) {
-                if (actualController.empty() && iOwnNext) return false;
-
-                auto prIt = plugin.sectorPriority.find(next);
-                if (prIt != plugin.sectorPriority.end()) {
-                    const auto& prioList = prIt->second;
-                    auto myPrio = std::find(prioList.begin(), prioList.end(), mySector);
-                    auto otherPrio = std::find(prioList.begin(), prioList.end(), actualController);
-                    if (myPrio != prioList.end() && otherPrio != prioList.end() && myPrio < otherPrio) return false;
-                }
-
+                if (nobodyOnline && iOwnNext) return false;
+                if (graph.Outranks(next, me, actualController)) return false;
                 return true;
             }
 
-            if (!nextIsDefined && actualController.empty()) return true; // external offline
-            if (!nextIsDefined && !_stricmp(actualController.c_str(), mySector.c_str())) return false; // I control
-            return true; // external and someone else online
+            return true; // external sector: offline, or someone else online
         }
         return false;
         };
 
     // Suppress LOAs whose *source* sector is controlled by someone who outranks me
-    auto isSourceSectorSuppressed = [&](const LOAEntry& e) -> bool {
-        if (e.sectors.empty()) return false;
-        for (const auto& src : e.sectors) {
-            std::string actual = resolveController(src);
-            if (actual.empty()) continue;
-            if (_stricmp(actual.c_str(), mySector.c_str()) == 0) continue;
-
-            auto prIt = plugin.sectorPriority.find(src);
-            if (prIt == plugin.sectorPriority.end()) continue;
-            const auto& prio = prIt->second;
-            auto meIt = std::find(prio.begin(), prio.end(), mySector);
-            auto himIt = std::find(prio.begin(), prio.end(), actual);
-            if (meIt != prio.end() && himIt != prio.end() && himIt < meIt) return true;
+    auto isSourceSectorSuppressed = [&](const LoaHotEntry& h) -> bool {
+        for (uint16_t src : h.sectorIds) {
+            const uint16_t actual = resolveController(src);
+            if (actual == SectorGraph::kNone || actual == me) continue;
+            if (graph.Outranks(src, actual, me)) return true;
         }
         return false;
         };
 
-    auto airportMatch = [&](const LOAEntry* e)->bool {
-        if (!e->originAirports.empty() &&
-            !plugin.MatchesAirport(e->originAirportSet, e->originAirportPrefixes, origin)) return false;
-        if (!e->destinationAirports.empty() &&
-            !plugin.MatchesAirport(e->destinationAirportSet, e->destinationAirportPrefixes, destination)) return false;
+    auto airportMatch = [&](const LoaHotEntry* h)->bool {
+        if ((h->constraintFlags & LOA_HAS_ORIGIN) &&
+            !MatchesAirport(h->entry->originAirportSet, h->entry->originAirportPrefixes, origin)) return false;
+        if ((h->constraintFlags & LOA_HAS_DESTINATION) &&
+            !MatchesAirport(h->entry->destinationAirportSet, h->entry->destinationAirportPrefixes, destination)) return false;
         return true;
         };
 
-    auto runwayMatch = [&](const LOAEntry* e)->bool {
-        if (!e) return false;
-        if (e->runways.empty()) return true; // no runway constraint
+    // Airports as RunwayTable IDs, resolved once up front so the runway gate has no side
+    // effects and can run in any order (LoaGateTable)
+    const uint16_t originRunwayAirport = runwayTable.AirportId(origin);
+    const uint16_t destinationRunwayAirport = runwayTable.AirportId(destination);
 
-        // Decide which airport + which active runway set to compare against
-        switch (e->listKind) {
+    // Which active runway set an entry is compared against
+    enum : uint8_t { kDepRunways = 1, kArrRunways = 2 };
+    auto runwaySide = [&](const LoaHotEntry& e) -> uint8_t {
+        if (!(e.constraintFlags & LOA_HAS_RUNWAYS)) return 0; // no runway constraint
+
+        switch (e.listKind) {
         case LOAListKind::Departure:
         case LOAListKind::DepartureFallback:
             // Departure lists compare against active DEP runways at ORIGIN airport
-            return plugin.MatchesActiveRunway(origin, /*isDeparture=*/true, e->runways);
+            return kDepRunways;
 
         case LOAListKind::Destination:
         case LOAListKind::DestinationFallback:
             // Destination lists compare against active ARR runways at DESTINATION airport
-            return plugin.MatchesActiveRunway(destination, /*isDeparture=*/false, e->runways);
+            return kArrRunways;
 
         default:
             // Unknown kind: only apply if entry clearly constrains one side
-            if (!e->destinationAirports.empty()) {
-                return plugin.MatchesActiveRunway(destination, /*isDeparture=*/false, e->runways);
-            }
-            if (!e->originAirports.empty()) {
-                return plugin.MatchesActiveRunway(origin, /*isDeparture=*/true, e->runways);
-            }
+            if (e.constraintFlags & LOA_HAS_DESTINATION) return kArrRunways;
+            if (e.constraintFlags & LOA_HAS_ORIGIN) return kDepRunways;
             // Sector-style entry: don't block on runways
-            return true;
+            return 0;
+        }
+        };
+    auto runwayMatch = [&](const LoaHotEntry* e)->bool {
+        if (!e) return false;
+        switch (runwaySide(*e)) {
+        case kDepRunways: return MatchesActiveRunway(originRunwayAirport, /*isDeparture=*/true, e->runwayMask);
+        case kArrRunways: return MatchesActiveRunway(destinationRunwayAirport, /*isDeparture=*/false, e->runwayMask);
+        default:          return true;
         }
         };
 
-    auto waypointsMatch = [&](const LOAEntry* e)->bool {
+    auto waypointsMatch = [&](const LoaHotEntry* h)->bool {
         // LOA waypoints are normalized to lowercase at JSON load; routeSet uses lowercase keys
-        for (const auto& wp : e->waypoints) {
+        if (!(h->constraintFlags & LOA_HAS_WAYPOINTS)) return true;
+        for (const auto& wp : h->entry->waypoints) {
             if (routeSet.count(wp) == 0) return false;
         }
         return true;
         };
 
-    auto notViaMatch = [&](const LOAEntry* e)->bool {
+    auto notViaMatch = [&](const LoaHotEntry* h)->bool {
         // NOT VIA waypoints are normalized to lowercase at JSON load; routeSet uses lowercase keys
-        for (const auto& wp : e->notViaWaypoints) {
+        if (!(h->constraintFlags & LOA_HAS_NOT_VIA)) return true;
+        for (const auto& wp : h->entry->notViaWaypoints) {
             if (routeSet.count(wp) != 0) return false; // forbidden waypoint present
         }
         return true;
@@ -338,7 +523,7 @@ const LOAEntry* MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp,
     // Altitude gate (simplified):
     // Only apply to Departure/Destination-style LOAs (those that constrain origin and/or destination)
     // and only when a numeric XFL is defined.
-    auto passesFinalAltitudeGate = [&](const LOAEntry* e) -> bool {
+    auto passesFinalAltitudeGate = [&](const LoaHotEntry* e) -> bool {
         if (!e) return false;
         if (e->xfl <= 0) return true; // no numeric XFL -> no altitude gate
         const int xflFeet = e->xfl * 100;
@@ -369,332 +554,398 @@ const LOAEntry* MatchLoaEntry(const EuroScopePlugIn::CFlightPlan& fp,
 
     // ---------------- Volume prediction caching (performance) ----------------
     // Evaluating volume entry can be expensive (position predictions + geometry).
-    // Cache entry minute per volume-id for the duration of this MatchLoaEntry call.
-    const auto& _volsAll = plugin.GetCustomVolumes();
-    std::unordered_map<std::string, int> _volEnterMinuteCache;
-    std::vector<PredSampleLL> _predSamplesLL;
-    bool _predSamplesReady = false;
-
-    auto _ensurePredSamples = [&]() {
-        if (_predSamplesReady) return;
-        BuildPredSamplesLL(fp, _predSamplesLL);
-        _predSamplesReady = true;
+    // Entry minutes for all volumes are computed in one sweep, on first use in this call.
+    const CustomVolumeSet& _volsAll = *volumeSnapshot;
+    std::vector<double> _volEnterTimes;
+    bool _volEnterTimesReady = false;
+
+    // Trajectory is projected once per match into the same plane as the volume polygons
+    auto _enterTime = [&](int volIndex) -> double {
+        if (_volEnterTimesReady) {
+            LOA_CACHE_HIT(LOA_CACHE_VOLUME_ENTRY);
+        }
+        else {
+            LOA_CACHE_MISS(LOA_CACHE_VOLUME_ENTRY);
+            std::vector<PredSample> samples;
+            BuildPredSamples(fp, GetPlanarProjection(), samples);
+            ComputeVolumeEntryTimes(samples, _volsAll, _volEnterTimes);
+            _volEnterTimesReady = true;
+        }
+        return _volEnterTimes[(size_t)volIndex];
         };
 
-    auto _getVolPtr = [&](const std::string& id) -> const CustomVolume* {
-        auto it = _volsAll.find(id);
-        if (it == _volsAll.end()) return nullptr;
-        return &it->second;
+    // Any referenced volume missing -> the LOA can never match
+    auto allVolumesKnown = [&](const std::vector<std::string>& ids) -> bool {
+        for (const auto& id : ids) {
+            if (_volsAll.Find(id) < 0) return false;
+        }
+        return true;
         };
 
-    auto _enterMinuteCached = [&](const std::string& id, const CustomVolume& v) -> int {
-        auto it = _volEnterMinuteCache.find(id);
-        if (it != _volEnterMinuteCache.end()) return it->second;
-        _ensurePredSamples();
-        int m = FirstEnterMinuteVolumeFromSamplesLL(_predSamplesLL, v);
-        _volEnterMinuteCache.emplace(id, m);
-        return m;
+    auto entersAny = [&](const std::vector<std::string>& ids) -> bool {
+        for (const auto& id : ids) {
+            if (_enterTime(_volsAll.Find(id)) != kNeverEnters) return true;
+        }
+        return false;
         };
 
-    auto volumesMatch = [&](const LOAEntry* e) -> bool {
-        if (!e) return false;
-        const bool hasEnter = !e->predictedEnterVolumes.empty();
-        const bool hasFrom = !e->predictedFromVolumes.empty();
-        const bool hasTo = !e->predictedToVolumes.empty();
+    auto volumesMatch = [&](const LoaHotEntry* h) -> bool {
+        if (!h) return false;
+        const bool hasEnter = (h->constraintFlags & LOA_HAS_ENTER_VOLUMES) != 0;
+        const bool hasFrom = (h->constraintFlags & LOA_HAS_FROM_VOLUMES) != 0;
+        const bool hasTo = (h->constraintFlags & LOA_HAS_TO_VOLUMES) != 0;
         if (!hasEnter && !hasFrom && !hasTo) return true; // no constraint
-        auto entersAny = [&](const std::vector<std::string>& ids) -> int {
-            int bestMinute = INT_MAX;
-            for (const auto& id : ids) {
-                const CustomVolume* v = _getVolPtr(id);
-                if (!v) return INT_MAX; // referenced volume missing -> do NOT match
-                int m = _enterMinuteCached(id, *v);
-                if (m < bestMinute) bestMinute = m;
-            }
-            return bestMinute;
-            };
+        const LOAEntry* e = h->entry;
 
         if (hasEnter) {
             // Any enter volume hit is enough
-            for (const auto& id : e->predictedEnterVolumes) {
-                const CustomVolume* v = _getVolPtr(id);
-                if (!v) return false; // missing volume -> no match
-                if (_enterMinuteCached(id, *v) != INT_MAX) return true;
-            }
-            return false;
+            if (!allVolumesKnown(e->predictedEnterVolumes)) return false;
+            return entersAny(e->predictedEnterVolumes);
         }
 
-        if (hasFrom && !hasTo) {
-            return entersAny(e->predictedFromVolumes) != INT_MAX;
-        }
-        if (!hasFrom && hasTo) {
-            return entersAny(e->predictedToVolumes) != INT_MAX;
-        }
+        if (hasFrom && !allVolumesKnown(e->predictedFromVolumes)) return false;
+        if (hasTo && !allVolumesKnown(e->predictedToVolumes)) return false;
+
+        if (hasFrom && !hasTo) return entersAny(e->predictedFromVolumes);
+        if (!hasFrom && hasTo) return entersAny(e->predictedToVolumes);
 
-        // from + to transition
-        // We require there exists a pair where enter(to) > enter(from).
-        // Compute entry minutes for each referenced volume; if any referenced volume is missing, fail.
-        std::vector<int> fromTimes;
-        fromTimes.reserve(e->predictedFromVolumes.size());
+        // from + to transition: some TO volume is entered strictly after some FROM volume.
+        // Entry times are exact, so comparing against the earliest FROM entry is decisive.
+        double firstFrom = kNeverEnters;
         for (const auto& id : e->predictedFromVolumes) {
-            const CustomVolume* v = _getVolPtr(id);
-            if (!v) return false;
-            fromTimes.push_back(_enterMinuteCached(id, *v));
+            const double t = _enterTime(_volsAll.Find(id));
+            if (t < firstFrom) firstFrom = t;
         }
-        std::vector<int> toTimes;
-        toTimes.reserve(e->predictedToVolumes.size());
+        if (firstFrom == kNeverEnters) return false;
+
         for (const auto& id : e->predictedToVolumes) {
-            const CustomVolume* v = _getVolPtr(id);
-            if (!v) return false;
-            toTimes.push_back(_enterMinuteCached(id, *v));
-        }
-        for (size_t i = 0; i < fromTimes.size(); ++i) {
-            if (fromTimes[i] == INT_MAX) continue;
-            for (size_t j = 0; j < toTimes.size(); ++j) {
-                if (toTimes[j] == INT_MAX) continue;
-                if (toTimes[j] > fromTimes[i]) return true;
-            }
+            const double t = _enterTime(_volsAll.Find(id));
+            if (t != kNeverEnters && t > firstFrom) return true;
         }
         return false;
         };
 
 
 
-    auto isVolumeLoaEntry = [&](const LOAEntry* e) -> bool {
+    auto isVolumeLoaEntry = [&](const LoaHotEntry* e) -> bool {
         if (!e) return false;
-        return !e->predictedEnterVolumes.empty()
-            || !e->predictedFromVolumes.empty()
-            || !e->predictedToVolumes.empty();
+        return (e->constraintFlags & LOA_HAS_VOLUMES) != 0;
         };
 
-    auto isDestinationKind = [&](const LOAEntry* e) -> bool {
+    auto isDestinationKind = [&](const LoaHotEntry* e) -> bool {
         if (!e) return false;
         return (e->listKind == LOAListKind::Destination || e->listKind == LOAListKind::DestinationFallback);
         };
-    auto isDepartureKind = [&](const LOAEntry* e) -> bool {
+    auto isDepartureKind = [&](const LoaHotEntry* e) -> bool {
         if (!e) return false;
         return (e->listKind == LOAListKind::Departure || e->listKind == LOAListKind::DepartureFallback);
         };
-    auto scoreEntry = [&](const LOAEntry* e)->int {
-        int score = 0;
-
-        // prefer destination over departure
-        if (!e->destinationAirports.empty()) score += 20;
-
-        // priority on next sectors
-        // mySector is computed once per match call
-        if (!e->nextSectors.empty()) {
-            for (const auto& next : e->nextSectors) {
-                std::string actual = resolveController(next);
-                if (!actual.empty()) {
-                    if (_stricmp(actual.c_str(), mySector.c_str()) == 0) score -= 10000;
-                    else {
-                        auto prIt = plugin.sectorPriority.find(next);
-                        if (prIt == plugin.sectorPriority.end()) break;
-                        const auto& prio = prIt->second;
-                        auto meIt = std::find(prio.begin(), prio.end(), mySector);
-                        auto himIt = std::find(prio.begin(), prio.end(), actual);
-                        if (meIt != prio.end() && himIt != prio.end() && himIt < meIt) score += 50;
-                    }
-                    break;
-                }
+    // Next-sector control state, resolved at most once per sector per call
+    enum : int8_t { kNextUnknown = 0, kNextOffline, kNextMine, kNextOutranksMe, kNextOther };
+    std::vector<int8_t> nextSectorState(graph.Size(), kNextUnknown);
+    auto dynamicScore = [&](const LoaHotEntry& e) -> int {
+        for (uint16_t next : e.nextSectorIds) {
+            if (next >= nextSectorState.size()) continue; // not in sector_ownership.json: never online
+            int8_t& state = nextSectorState[next];
+            if (state == kNextUnknown) {
+                const uint16_t actual = resolveController(next);
+                if (actual == SectorGraph::kNone) state = kNextOffline;
+                else if (actual == me) state = kNextMine;
+                else if (graph.Outranks(next, actual, me)) state = kNextOutranksMe;
+                else state = kNextOther;
             }
+            if (state == kNextOffline) continue;
+            if (state == kNextMine) return kScoreNextMine;
+            if (state == kNextOutranksMe) return kScoreNextOutranksMe;
+            return 0;
         }
-
-        // small bonus if COP text present (tie-break)
-        if (!e->copText.empty()) score += 5;
-
-        // tie-break on higher XFL last
-        score += e->xfl;
-
-        return score;
+        return 0;
+        };
+    auto scoreEntry = [&](const LoaHotEntry* e)->int {
+        return e->staticScore + dynamicScore(*e);
+        };
+    // Nothing at or after e in a score-sorted sequence can replace the current best
+    auto cannotBeatBest = [&](const LoaHotEntry* e, const LoaHotEntry* currentBest, int currentBestScore) -> bool {
+        return currentBest && e->staticScore + kScoreNextMax <= currentBestScore;
         };
 
-    // Build candidate set from waypoint index (already includes dest/dep/LOR)
-    std::unordered_set<const LOAEntry*> candidates;
-    candidates.reserve(256);
-    // routeSet already contains lowercased fixes
-    for (const auto& lwp : routeSet) {
-        auto it = plugin.indexByWaypoint.find(lwp);
-
-        if (it != plugin.indexByWaypoint.end()) {
-            candidates.insert(it->second.begin(), it->second.end());
+    // Build candidate set from waypoint index (already includes dest/dep/LOR).
+    // Buckets are sorted by LoaScoreOrder; merging them keeps that order and puts
+    // duplicates next to each other.
+    std::vector<const LoaHotEntry*> candidates;
+    {
+        LOA_TRACE_SCOPE("match", "candidates");
+        std::vector<std::pair<const std::vector<const LoaHotEntry*>*, size_t>> buckets;
+        size_t total = 0;
+        // routeSet already contains lowercased fixes
+        for (const auto& lwp : routeSet) {
+            auto it = indexByWaypoint.find(lwp);
+            if (it != indexByWaypoint.end() && !it->second.empty()) {
+                buckets.push_back(std::make_pair(&it->second, (size_t)0));
+                total += it->second.size();
+            }
+        }
+        candidates.reserve(total);
+        auto headAfter = [](const std::pair<const std::vector<const LoaHotEntry*>*, size_t>& a,
+            const std::pair<const std::vector<const LoaHotEntry*>*, size_t>& b) {
+                return LoaScoreOrder((*b.first)[b.second], (*a.first)[a.second]);
+            };
+        std::make_heap(buckets.begin(), buckets.end(), headAfter);
+        while (!buckets.empty()) {
+            std::pop_heap(buckets.begin(), buckets.end(), headAfter);
+            auto& top = buckets.back();
+            const LoaHotEntry* e = (*top.first)[top.second];
+            if (candidates.empty() || candidates.back() != e) candidates.push_back(e);
+            if (++top.second < top.first->size()) std::push_heap(buckets.begin(), buckets.end(), headAfter);
+            else buckets.pop_back();
         }
     }
     // Also consider entries with no waypoints (rare)
     // (We skip global scan for perf; those should still have at least one wpt to be indexed.)
 
-    const LOAEntry* best = nullptr;
-    int bestScore = INT_MIN;
-
-    auto considerCandidate = [&](const LOAEntry* e) {
-        if (!e) return;
-        if (isExcludedDest(*e) || isExcludedOrigin(*e)) return;
-        if (isSourceSectorSuppressed(*e)) return;
-        if (!e->nextSectors.empty() && !shouldMatchLOA(e->nextSectors)) return;
-        if (!airportMatch(e)) return;
-        if (!runwayMatch(e)) return;
-        if (!passesFinalAltitudeGate(e)) return;
-        if (!volumesMatch(e)) return;
-        if (!notViaMatch(e)) return;
-        if (!waypointsMatch(e)) return;
-
-        int s = scoreEntry(e);
-        if (!best || s > bestScore) {
-            best = e;
-            bestScore = s;
+    // Every gate is a pure function of the flight and the entry, so any order gives the same result
+    auto passesGate = [&](uint8_t gate, const LoaHotEntry& e) -> bool {
+        switch (gate) {
+        case LOA_GATE_SOURCE_SUPPRESSED: return !isSourceSectorSuppressed(e);
+        case LOA_GATE_NEXT_SECTOR:       return !(e.constraintFlags & LOA_HAS_NEXT_SECTORS) || shouldMatchLOA(e.nextSectorIds);
+        case LOA_GATE_AIRPORT:           return airportMatch(&e);
+        case LOA_GATE_RUNWAY:            return runwayMatch(&e);
+        case LOA_GATE_FINAL_ALTITUDE:    return passesFinalAltitudeGate(&e);
+        case LOA_GATE_VOLUMES:           return volumesMatch(&e);
+        case LOA_GATE_NOT_VIA:           return notViaMatch(&e);
+        case LOA_GATE_WAYPOINTS:         return waypointsMatch(&e);
+        default:                         return true;
         }
         };
 
-    // Priority:
-    // 1) Destination LOAs (non-volume)
-    for (const LOAEntry* e : candidates) {
-        if (!e) continue;
-        if (!isDestinationKind(e)) continue;
-        if (isVolumeLoaEntry(e)) continue;
-        considerCandidate(e);
-    }
+    // Gate statistics of this match; the scan only reads the table, which is updated
+    // once afterwards
+    LoaGateTable& gateTable = loaGates;
+    std::array<LoaGateCounters, LOA_GATE_COUNT> gateCounts;
+    uint32_t gateChains = 0;
+
+    struct Selection {
+        const LoaHotEntry* best;
+        uint64_t sectorMask;
+        uint8_t runwayDeps;
+    };
+
+    // Picks the winner with the gates run in 'order'; counts them only if 'countGates'
+    auto selectEntry = [&](const std::array<uint8_t, LOA_GATE_COUNT>& order, bool countGates) -> Selection {
+        const LoaHotEntry* best = nullptr;
+        int bestScore = INT_MIN;
+
+        // Sectors whose controller decides between the entries considered below; a change in
+        // any of them (CheckForOwnershipChange) invalidates this match. The runway sets they
+        // compare against are recorded the same way, independent of the gate order.
+        uint64_t sectorMask = 0;
+        uint8_t runwayDeps = 0;
+
+        // All gates in 'order', counting evaluations/rejections and timing one chain in
+        // LoaGateTable::kSampleEvery
+        auto passesGates = [&](const LoaHotEntry& e) -> bool {
+            if (!countGates) {
+                for (uint8_t gate : order) {
+                    if (!passesGate(gate, e)) return false;
+                }
+                return true;
+            }
+
+            const bool sample = ((gateTable.chainEvaluations + gateChains) % LoaGateTable::kSampleEvery) == 0;
+            ++gateChains;
+            for (uint8_t gate : order) {
+                LoaGateCounters& c = gateCounts[gate];
+                ++c.evaluations;
+                bool ok;
+                if (sample) {
+                    const auto t0 = std::chrono::steady_clock::now();
+                    ok = passesGate(gate, e);
+                    c.sampledNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - t0).count();
+                    ++c.samples;
+                }
+                else {
+                    ok = passesGate(gate, e);
+                }
+                if (!ok) {
+                    ++c.rejections;
+                    return false;
+                }
+            }
+            return true;
+            };
+
+        auto considerCandidate = [&](const LoaHotEntry* e) {
+            if (!e) return;
+            if (isExcludedDest(*e) || isExcludedOrigin(*e)) return;
+            sectorMask |= e->sectorMask;
+            runwayDeps |= runwaySide(*e);
+            if (!passesGates(*e)) return;
+
+            int s = scoreEntry(e);
+            if (!best || s > bestScore) {
+                best = e;
+                bestScore = s;
+            }
+            };
 
-    // 2) Departure LOAs (non-volume)
-    if (!best) {
-        for (const LOAEntry* e : candidates) {
+        LOA_TRACE_BEGIN(indexedSpan, "match", "indexedPhases");
+        // Priority:
+        // 1) Destination LOAs (non-volume)
+        for (const LoaHotEntry* e : candidates) {
             if (!e) continue;
-            if (!isDepartureKind(e)) continue;
+            if (cannotBeatBest(e, best, bestScore)) break;
+            if (!isDestinationKind(e)) continue;
             if (isVolumeLoaEntry(e)) continue;
             considerCandidate(e);
         }
-    }
 
-    // 2b) Other non-volume (sector-style etc.)
-    if (!best) {
-        for (const LOAEntry* e : candidates) {
-            if (!e) continue;
-            if (isDestinationKind(e) || isDepartureKind(e)) continue;
-            if (isVolumeLoaEntry(e)) continue;
-            considerCandidate(e);
+        // 2) Departure LOAs (non-volume)
+        if (!best) {
+            for (const LoaHotEntry* e : candidates) {
+                if (!e) continue;
+                if (cannotBeatBest(e, best, bestScore)) break;
+                if (!isDepartureKind(e)) continue;
+                if (isVolumeLoaEntry(e)) continue;
+                considerCandidate(e);
+            }
         }
-    }
 
-    // 3) Volume LOAs (enter / from-to), regardless of list kind
-    if (!best) {
-        for (const LOAEntry* e : candidates) {
-            if (!e) continue;
-            if (!isVolumeLoaEntry(e)) continue;
-            considerCandidate(e);
+        // 2b) Other non-volume (sector-style etc.)
+        if (!best) {
+            for (const LoaHotEntry* e : candidates) {
+                if (!e) continue;
+                if (cannotBeatBest(e, best, bestScore)) break;
+                if (isDestinationKind(e) || isDepartureKind(e)) continue;
+                if (isVolumeLoaEntry(e)) continue;
+                considerCandidate(e);
+            }
         }
-    }
 
-    // ---- NEW: Slow normal scan (destination then departure) before any fallback ----
-    if (!best) {
-        auto consider_nonvolume = [&](const std::vector<LOAEntry>& list) {
-            for (const auto& e : list) {
-                if (isVolumeLoaEntry(&e)) continue; // volume LOAs are handled in phase 3
-                if (isExcludedDest(e) || isExcludedOrigin(e)) continue;
-                if (isSourceSectorSuppressed(e)) continue;
-                if (!e.nextSectors.empty() && !shouldMatchLOA(e.nextSectors)) continue;
-                if (!airportMatch(&e)) continue;
-                if (!runwayMatch(&e)) continue;
-                if (!passesFinalAltitudeGate(&e)) continue;
-                if (!volumesMatch(&e)) continue;
-                if (!notViaMatch(&e)) continue;
-                if (!waypointsMatch(&e)) continue;
+        // 3) Volume LOAs (enter / from-to), regardless of list kind
+        if (!best) {
+            for (const LoaHotEntry* e : candidates) {
+                if (!e) continue;
+                if (cannotBeatBest(e, best, bestScore)) break;
+                if (!isVolumeLoaEntry(e)) continue;
+                considerCandidate(e);
+            }
+        }
 
-                int s = scoreEntry(&e);
-                if (!best || s > bestScore) { best = &e; bestScore = s; }
+        LOA_TRACE_END(indexedSpan);
+
+        // ---- NEW: Slow normal scan (destination then departure) before any fallback ----
+        if (!best) {
+            LOA_TRACE_SCOPE("match", "slowScan");
+            auto consider_nonvolume = [&](const std::vector<const LoaHotEntry*>& list) {
+                for (const LoaHotEntry* pe : list) {
+                    const LoaHotEntry& e = *pe;
+                    if (isVolumeLoaEntry(&e)) continue; // volume LOAs are handled in phase 3
+                    if (isExcludedDest(e) || isExcludedOrigin(e)) continue;
+                    sectorMask |= e.sectorMask;
+                    runwayDeps |= runwaySide(e);
+                    if (cannotBeatBest(&e, best, bestScore)) continue; // lists are in load order: skip, don't stop
+                    if (!passesGates(e)) continue;
+
+                    int s = scoreEntry(&e);
+                    if (!best || s > bestScore) { best = &e; bestScore = s; }
+                }
+                };
+
+            auto consider_volume = [&](const std::vector<const LoaHotEntry*>& list) {
+                for (const LoaHotEntry* pe : list) {
+                    const LoaHotEntry& e = *pe;
+                    if (!isVolumeLoaEntry(&e)) continue;
+                    if (isExcludedDest(e) || isExcludedOrigin(e)) continue;
+                    sectorMask |= e.sectorMask;
+                    runwayDeps |= runwaySide(e);
+                    if (cannotBeatBest(&e, best, bestScore)) continue; // lists are in load order: skip, don't stop
+                    if (!passesGates(e)) continue;
+
+                    int s = scoreEntry(&e);
+                    if (!best || s > bestScore) { best = &e; bestScore = s; }
+                }
+                };
+
+            // Priority: Destination -> Departure -> Volume
+            consider_nonvolume(destinationLoas);
+            if (!best) consider_nonvolume(departureLoas);
+            if (!best) {
+                consider_volume(destinationLoas);
+                if (!best) consider_volume(departureLoas);
             }
-            };
+        }
+        // -----------------------------------------------------------------------------
 
-        auto consider_volume = [&](const std::vector<LOAEntry>& list) {
-            for (const auto& e : list) {
-                if (!isVolumeLoaEntry(&e)) continue;
+        // -------------------- Fallback pass (only if nothing matched) --------------------
+        if (!best) {
+            LOA_TRACE_SCOPE("match", "fallback");
+            // Reuse airportMatch (no waypoint checks for fallbacks); the list bonus is part of
+            // the static score (LoaStaticScore)
+            auto scoreFallback = [&](const LoaHotEntry& e)->int {
+                return e.staticScore + dynamicScore(e);
+                };
+
+            const LoaHotEntry* bestDestFB = nullptr; int bestDestFBScore = INT_MIN;
+            for (const LoaHotEntry* pe : destinationFallbackLoas) {
+                const LoaHotEntry& e = *pe;
                 if (isExcludedDest(e) || isExcludedOrigin(e)) continue;
-                if (isSourceSectorSuppressed(e)) continue;
-                if (!e.nextSectors.empty() && !shouldMatchLOA(e.nextSectors)) continue;
-                if (!airportMatch(&e)) continue;
+                sectorMask |= e.sectorMask;
+                runwayDeps |= runwaySide(e);
+                if (cannotBeatBest(&e, bestDestFB, bestDestFBScore)) continue;
+                if (isSourceSectorSuppressed(e)) continue;                   // ownership suppression
+                if ((e.constraintFlags & LOA_HAS_NEXT_SECTORS) && !shouldMatchLOA(e.nextSectorIds)) continue;
+                if (!airportMatch(&e)) continue;                             // ONLY airport constraints; no waypoints
                 if (!runwayMatch(&e)) continue;
                 if (!passesFinalAltitudeGate(&e)) continue;
-                if (!volumesMatch(&e)) continue;
                 if (!notViaMatch(&e)) continue;
-                if (!waypointsMatch(&e)) continue;
-
-                int s = scoreEntry(&e);
-                if (!best || s > bestScore) { best = &e; bestScore = s; }
+                int s = scoreFallback(e);
+                if (!bestDestFB || s > bestDestFBScore) { bestDestFB = &e; bestDestFBScore = s; }
             }
-            };
 
-        // Priority: Destination -> Departure -> Volume
-        consider_nonvolume(destinationLoas);
-        if (!best) consider_nonvolume(departureLoas);
-        if (!best) {
-            consider_volume(destinationLoas);
-            if (!best) consider_volume(departureLoas);
-        }
-    }
-    // -----------------------------------------------------------------------------
-
-    // -------------------- Fallback pass (only if nothing matched) --------------------
-    if (!best) {
-        // Reuse airportMatch (no waypoint checks for fallbacks)
-        auto scoreFallback = [&](const LOAEntry& e, bool isDepartureList)->int {
-            int s = 0;
-            if (!isDepartureList) s += 20; // prefer destination fallback slightly
-
-            // ownership/priority tie-breaks (same as main scoring)
-            // mySector is computed once per match call
-            if (!e.nextSectors.empty()) {
-                for (const auto& next : e.nextSectors) {
-                    std::string actual = resolveController(next);
-                    if (!actual.empty()) {
-                        if (_stricmp(actual.c_str(), mySector.c_str()) == 0) s -= 10000;
-                        else {
-                            auto prIt = plugin.sectorPriority.find(next);
-                            if (prIt != plugin.sectorPriority.end()) {
-                                const auto& prio = prIt->second;
-                                auto meIt = std::find(prio.begin(), prio.end(), mySector);
-                                auto himIt = std::find(prio.begin(), prio.end(), actual);
-                                if (meIt != prio.end() && himIt != prio.end() && himIt < meIt) s += 50;
-                            }
-                        }
-                        break;
-                    }
-                }
+            const LoaHotEntry* bestDepFB = nullptr; int bestDepFBScore = INT_MIN;
+            for (const LoaHotEntry* pe : departureFallbackLoas) {
+                const LoaHotEntry& e = *pe;
+                sectorMask |= e.sectorMask;
+                if (cannotBeatBest(&e, bestDepFB, bestDepFBScore)) continue;
+                if (isSourceSectorSuppressed(e)) continue;
+                if ((e.constraintFlags & LOA_HAS_NEXT_SECTORS) && !shouldMatchLOA(e.nextSectorIds)) continue;
+                if (!airportMatch(&e)) continue;                             // ONLY airport constraints; no waypoints
+                if (!notViaMatch(&e)) continue;
+                int s = scoreFallback(e);
+                if (!bestDepFB || s > bestDepFBScore) { bestDepFB = &e; bestDepFBScore = s; }
             }
 
-            if (!e.copText.empty()) s += 5;
-            s += e.xfl; // higher XFL slight tie-break
-            return s;
-            };
-
-        const LOAEntry* bestDestFB = nullptr; int bestDestFBScore = INT_MIN;
-        for (const auto& e : destinationFallbackLoas) {
-            if (isExcludedDest(e) || isExcludedOrigin(e)) continue;
-            if (isSourceSectorSuppressed(e)) continue;                   // ownership suppression
-            if (!e.nextSectors.empty() && !shouldMatchLOA(e.nextSectors)) continue;
-            if (!airportMatch(&e)) continue;                             // ONLY airport constraints; no waypoints
-            if (!runwayMatch(&e)) continue;
-            if (!passesFinalAltitudeGate(&e)) continue;
-            if (!notViaMatch(&e)) continue;
-            int s = scoreFallback(e, /*isDepartureList=*/false);
-            if (!bestDestFB || s > bestDestFBScore) { bestDestFB = &e; bestDestFBScore = s; }
+            // Strict priority: destination fallback before departure fallback
+            if (bestDestFB) best = bestDestFB;
+            else if (bestDepFB) best = bestDepFB;
         }
+        // -------------------------------------------------------------------------------
 
-        const LOAEntry* bestDepFB = nullptr; int bestDepFBScore = INT_MIN;
-        for (const auto& e : departureFallbackLoas) {
-            if (isSourceSectorSuppressed(e)) continue;
-            if (!e.nextSectors.empty() && !shouldMatchLOA(e.nextSectors)) continue;
-            if (!airportMatch(&e)) continue;                             // ONLY airport constraints; no waypoints
-            if (!notViaMatch(&e)) continue;
-            int s = scoreFallback(e, /*isDepartureList=*/true);
-            if (!bestDepFB || s > bestDepFBScore) { bestDepFB = &e; bestDepFBScore = s; }
-        }
+        return Selection{ best, sectorMask, runwayDeps };
+        };
 
-        // Strict priority: destination fallback before departure fallback
-        if (bestDestFB) best = bestDestFB;
-        else if (bestDepFB) best = bestDepFB;
+    const Selection selected = selectEntry(gateTable.order, /*countGates=*/true);
+    gateTable.Record(gateCounts, gateChains);
+
+    // Differential check: the same inputs again with the gates in fixed order must pick the
+    // same entry and record the same dependencies
+    if (gateTable.verify) {
+        const Selection reference = selectEntry(LoaGateTable::FixedOrder(), /*countGates=*/false);
+        const bool same = reference.best == selected.best &&
+            reference.sectorMask == selected.sectorMask &&
+            reference.runwayDeps == selected.runwayDeps;
+        gateTable.RecordVerify(same, fp.GetCallsign());
     }
-    // -------------------------------------------------------------------------------
 
-    plugin.matchedLOACache[callsign] = best;
-    plugin.matchTimestamps[callsign] = now;
-    plugin.matchVersions[callsign] = plugin.sectorControlVersion;
-    return best;
+    // The full entry is read only here, for the winner
+    const LOAEntry* matched = selected.best ? selected.best->entry : nullptr;
+    flight.matchedEntry = matched;
+    flight.matchTs = now;
+    flight.matchVersion = sectorControlVersion;
+    flight.matchVolumeGeneration = volumeSnapshot->generation;
+    flight.matchSectorMask = selected.sectorMask;
+    flight.matchDepRunwayAirport = (selected.runwayDeps & kDepRunways) ? originRunwayAirport : RunwayTable::kNone;
+    flight.matchArrRunwayAirport = (selected.runwayDeps & kArrRunways) ? destinationRunwayAirport : RunwayTable::kNone;
+    return matched;
 }
\ No newline at end of file
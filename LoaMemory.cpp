@@ -0,0 +1,148 @@
+﻿// =========================
+// File: LoaMemory.cpp
+// =========================
+// ".loa mem": estimated heap use per plugin structure (see LoaMemory.h for the model).
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include "LoaMemory.h"
+#include <cstdio>
+
+size_t LoaMemory::LoaEntryHeap(const LOAEntry& e)
+{
+    return Strings(e.sectors) + Strings(e.waypoints) + Strings(e.notViaWaypoints) +
+        Strings(e.predictedEnterVolumes) + Strings(e.predictedFromVolumes) + Strings(e.predictedToVolumes) +
+        Strings(e.originAirports) + Strings(e.destinationAirports) + Strings(e.nextSectors) +
+        Strings(e.runways) + StringHeap(e.xflText) + StringHeap(e.copText) +
+        StringSet(e.originAirportSet) + Strings(e.originAirportPrefixes) +
+        StringSet(e.destinationAirportSet) + Strings(e.destinationAirportPrefixes) +
+        Strings(e.excludeDestinationAirports) + StringSet(e.excludeDestinationAirportSet) +
+        Strings(e.excludeDestinationAirportPrefixes) +
+        Strings(e.excludeOriginAirports) + StringSet(e.excludeOriginAirportSet) +
+        Strings(e.excludeOriginAirportPrefixes);
+}
+
+namespace {
+    template <typename V, typename H, typename E, typename A>
+    size_t PointerBuckets(const std::unordered_map<std::string, std::vector<V>, H, E, A>& index)
+    {
+        size_t bytes = LoaMemory::StringKeyedMap(index);
+        for (const auto& kv : index) bytes += LoaMemory::Vector(kv.second);
+        return bytes;
+    }
+
+    template <typename H, typename E, typename A>
+    size_t StringListMap(const std::unordered_map<std::string, std::vector<std::string>, H, E, A>& m)
+    {
+        size_t bytes = LoaMemory::StringKeyedMap(m);
+        for (const auto& kv : m) bytes += LoaMemory::Strings(kv.second);
+        return bytes;
+    }
+
+    template <typename H, typename E, typename A>
+    size_t StringValueMap(const std::unordered_map<std::string, std::string, H, E, A>& m)
+    {
+        size_t bytes = LoaMemory::StringKeyedMap(m);
+        for (const auto& kv : m) bytes += LoaMemory::StringHeap(kv.second);
+        return bytes;
+    }
+
+    size_t KB(size_t bytes) { return (bytes + 1023) / 1024; }
+}
+
+void LOAPlugin::ReportMemory()
+{
+    using namespace LoaMemory;
+    char buf[256];
+    auto line = [&](const char* what, size_t bytes, const char* detail) {
+        sprintf_s(buf, sizeof(buf), "%-15s ~%u KB%s%s", what, (unsigned)KB(bytes),
+            detail[0] ? ", " : "", detail);
+        DisplayUserMessage("LOA Plugin", "Memory", buf, true, true, false, false, false);
+        };
+    char detail[160];
+    size_t total = 0;
+
+    // LOA tables: entries (inline + owned heap), their hot arrays and the active pointer lists
+    size_t tables = 0;
+    size_t entries = 0;
+    for (const auto& kv : loadedSectorLoas) {
+        tables += sizeof(kv) + StringHeap(kv.first) + 3 * sizeof(void*); // std::map node
+        tables += Vector(kv.second);
+        for (const LOAEntry& e : kv.second) tables += LoaEntryHeap(e);
+        entries += kv.second.size();
+    }
+    for (const auto& kv : loadedSectorLoaHot) {
+        tables += sizeof(kv) + StringHeap(kv.first) + 3 * sizeof(void*); // std::map node
+        tables += Vector(kv.second);
+    }
+    tables += loadedLoaArena.BytesReserved();
+    tables += Vector(destinationLoas) + Vector(departureLoas) +
+        Vector(destinationFallbackLoas) + Vector(departureFallbackLoas);
+    sprintf_s(detail, sizeof(detail), "%u entries of %u bytes (hot %u bytes)",
+        (unsigned)entries, (unsigned)sizeof(LOAEntry), (unsigned)sizeof(LoaHotEntry));
+    line("LOA tables", tables, detail);
+    total += tables;
+
+    const size_t indexes = PointerBuckets(indexByWaypoint) + PointerBuckets(indexByNextSector) +
+        HashSet(validLoaEntryPtrs) + Strings(loadedSectorOrder) + StringSet(activeLoaSectors) +
+        StringKeyedMap(sectorBitIds) + StringValueMap(trackedSectorControl) +
+        StringSet(aorDestinationSet) + Strings(aorDestinationPrefixes);
+    sprintf_s(detail, sizeof(detail), "%u waypoint buckets", (unsigned)indexByWaypoint.size());
+    line("LOA indexes", indexes, detail);
+    total += indexes;
+
+    const size_t ownership = StringListMap(sectorOwnership) + StringListMap(sectorPriority) +
+        sectorGraph.FootprintBytes() + Vector(resolvedStation) + Vector(resolvedValid) + Vector(onlineById);
+    sprintf_s(detail, sizeof(detail), "%u graph sectors", (unsigned)sectorGraph.Size());
+    line("Sector graph", ownership, detail);
+    total += ownership;
+
+    const size_t runways = runwayTable.FootprintBytes() + Vector(runwayChanges);
+    sprintf_s(detail, sizeof(detail), "%u airports", (unsigned)runwayTable.AirportCount());
+    line("Active runways", runways, detail);
+    total += runways;
+
+    size_t volumes = 0;
+    const CustomVolumeSnapshot vols = GetCustomVolumes();
+    if (vols) {
+        volumes += sizeof(CustomVolumeSet) + Vector(vols->volumes) + vols->bands.FootprintBytes();
+        for (const CustomVolume& v : vols->volumes) volumes += StringHeap(v.id) + Vector(v.polygon);
+        volumes += StringKeyedMap(vols->indexById);
+    }
+    sprintf_s(detail, sizeof(detail), "%u volumes", vols ? (unsigned)vols->volumes.size() : 0u);
+    line("Volumes", volumes, detail);
+    total += volumes;
+
+    size_t polygons = Vector(sectorPolygons) + sectorPolygonGrid.FootprintBytes();
+    for (const SectorPolygon& p : sectorPolygons) polygons += StringHeap(p.sectorId) + Vector(p.pts);
+    sprintf_s(detail, sizeof(detail), "%u polygons", (unsigned)sectorPolygons.size());
+    line("Sector polygons", polygons, detail);
+    total += polygons;
+
+    const size_t online = StringSet(cachedOnlineControllers) + StringSet(currentFrameOnlineControllers) +
+        StringKeyedMap(onlineStationRefs) + StringValueMap(onlineStationByCallsign) +
+        controllerDirectory.FootprintBytes();
+    sprintf_s(detail, sizeof(detail), "%u stations", (unsigned)cachedOnlineControllers.size());
+    line("Controllers", online, detail);
+    total += online;
+
+    // Per-flight caches, split by what owns the bytes
+    size_t routes = 0, routeSets = 0;
+    flightStates.ForEach([&](uint32_t, FlightState& fs) {
+        routes += Strings(fs.routePoints);
+        routeSets += StringSet(fs.routeSet);
+        });
+    const size_t records = flightStates.Capacity() * sizeof(FlightState);
+    const size_t flights = flightStates.FootprintBytes();
+    sprintf_s(detail, sizeof(detail), "records %u KB, routes %u KB, route sets %u KB, table %u KB, other %u KB",
+        (unsigned)KB(records), (unsigned)KB(routes), (unsigned)KB(routeSets),
+        (unsigned)KB(flightStates.IndexBytes()),
+        (unsigned)KB(flights - records - routes - routeSets - flightStates.IndexBytes()));
+    line("Flight states", flights, detail);
+    total += flights;
+
+    ReportFlightStateMemory();
+    sprintf_s(buf, sizeof(buf), "Total ~%u KB; flight states peaked at ~%u KB / %u flights",
+        (unsigned)KB(total), (unsigned)KB(flightStatePeakBytes), (unsigned)flightStatePeakLive);
+    DisplayUserMessage("LOA Plugin", "Memory", buf, true, true, false, false, false);
+}
@@ -0,0 +1,70 @@
+﻿#pragma once
+
+// =============================
+// Heap accounting (".loa mem")
+// =============================
+// Estimates from container capacities, following the MSVC layouts the plugin ships
+// with: strings keep 15 chars inline (SSO), hash containers are one list node per
+// element (value + two links) plus two pointers per bucket. Allocator headers are not
+// counted, so figures are a lower bound that is stable enough to spot growth.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+struct LOAEntry;
+
+namespace LoaMemory {
+	template <typename S>
+	inline size_t StringHeap(const S& s)
+	{
+		// Short strings live inline (SSO); only count real heap buffers
+		return (s.capacity() > 15) ? s.capacity() + 1 : 0;
+	}
+
+	template <typename T>
+	inline size_t Vector(const std::vector<T>& v)
+	{
+		return v.capacity() * sizeof(T);
+	}
+
+	inline size_t Strings(const std::vector<std::string>& v)
+	{
+		size_t bytes = Vector(v);
+		for (const std::string& s : v) bytes += StringHeap(s);
+		return bytes;
+	}
+
+	template <typename C>
+	inline size_t HashNodes(const C& c, size_t valueBytes)
+	{
+		return c.bucket_count() * 2 * sizeof(void*) + c.size() * (valueBytes + 2 * sizeof(void*));
+	}
+
+	template <typename K, typename H, typename E, typename A>
+	inline size_t HashSet(const std::unordered_set<K, H, E, A>& s)
+	{
+		return HashNodes(s, sizeof(K));
+	}
+
+	inline size_t StringSet(const std::unordered_set<std::string>& s)
+	{
+		size_t bytes = HashSet(s);
+		for (const std::string& v : s) bytes += StringHeap(v);
+		return bytes;
+	}
+
+	// Map nodes and string keys; mapped values are counted by the caller when they own heap
+	template <typename V, typename H, typename E, typename A>
+	inline size_t StringKeyedMap(const std::unordered_map<std::string, V, H, E, A>& m)
+	{
+		size_t bytes = HashNodes(m, sizeof(std::pair<const std::string, V>));
+		for (const auto& kv : m) bytes += StringHeap(kv.first);
+		return bytes;
+	}
+
+	// Heap owned by one entry (not sizeof(LOAEntry) itself)
+	size_t LoaEntryHeap(const LOAEntry& e);
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+
+// =============================
+// Name keys for the interning tables
+// =============================
+// SectorGraph, RunwayTable and ControllerDirectory key their IDs by LoaNameKey: trimmed
+// and upper case. Sector IDs, positions, ICAO codes and runway designators arrive upper
+// case in practice, so FindInternedId tries a name as given and folds it only on a miss.
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+// Trimmed, upper-case copy. These names fit the small-string buffer, so this does not allocate.
+inline std::string LoaNameKey(const char* s)
+{
+	std::string out;
+	if (!s) return out;
+	while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') ++s;
+	for (; *s; ++s) out.push_back((char)std::toupper((unsigned char)*s));
+	while (!out.empty() && (out.back() == ' ' || out.back() == '\t' ||
+		out.back() == '\r' || out.back() == '\n'))
+		out.pop_back();
+	return out;
+}
+
+inline std::string LoaNameKey(const std::string& s) { return LoaNameKey(s.c_str()); }
+
+// ID of 'name' in a LoaNameKey-keyed map, or 'none'
+template <class IdMap>
+uint16_t FindInternedId(const IdMap& ids, const std::string& name, uint16_t none)
+{
+	auto it = ids.find(name);
+	if (it != ids.end()) return it->second;
+	it = ids.find(LoaNameKey(name));
+	return (it != ids.end()) ? it->second : none;
+}
@@ -0,0 +1,173 @@
+﻿// =========================
+// File: LoaStats.cpp
+// =========================
+// Latency histograms for the plugin's hot paths and the ".loa stats" report.
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include "LoaStats.h"
+#include <cstdio>
+#include <fstream>
+
+LoaStatsTable loaStats;
+
+const int LoaLatencyHistogram::kBuckets;
+
+void LoaLatencyHistogram::Record(uint64_t ns)
+{
+    int b = 0;
+    for (uint64_t v = ns; v > 1 && b < kBuckets - 1; v >>= 1) ++b;
+    ++buckets[b];
+    ++count;
+    totalNs += ns;
+    if (ns > maxNs) maxNs = ns;
+}
+
+uint64_t LoaLatencyHistogram::Percentile(double p) const
+{
+    if (count == 0) return 0;
+    const uint64_t rank = (uint64_t)(p * (double)count);
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (seen > rank) {
+            const uint64_t upper = (b + 1 < 64) ? (1ULL << (b + 1)) : UINT64_MAX;
+            return (upper < maxNs) ? upper : maxNs;
+        }
+    }
+    return maxNs;
+}
+
+void LoaStatsTable::Reset()
+{
+    for (LoaLatencyHistogram& h : sites) h = LoaLatencyHistogram();
+    for (LoaCacheCounters& c : caches) c = LoaCacheCounters();
+}
+
+const char* LoaStatsTable::SiteName(LoaStatSite site)
+{
+    switch (site) {
+    case LOA_STAT_GET_TAG_ITEM:    return "OnGetTagItem";
+    case LOA_STAT_MATCH:           return "MatchLoaEntry";
+    case LOA_STAT_LOAD_LOAS:       return "LoadLOAsFromJSON";
+    case LOA_STAT_RUNWAY_POLL:     return "PollActiveRunways";
+    case LOA_STAT_OWNERSHIP_CHECK: return "OwnershipCheck";
+    case LOA_STAT_HANDOFF_POPUP:   return "HandoffPopupOpen";
+    default:                       return "?";
+    }
+}
+
+const char* LoaStatsTable::CacheName(LoaCacheId cache)
+{
+    switch (cache) {
+    case LOA_CACHE_TAG_BUNDLE:         return "tagBundle";
+    case LOA_CACHE_MATCH:              return "match";
+    case LOA_CACHE_ROUTE:              return "route";
+    case LOA_CACHE_ROUTE_SET:          return "routeSet";
+    case LOA_CACHE_SECTOR_RESOLUTION:  return "sectorResolution";
+    case LOA_CACHE_ONLINE_CONTROLLERS: return "onlineControllers";
+    case LOA_CACHE_VOLUME_ENTRY:       return "volumeEntry";
+    default:                           return "?";
+    }
+}
+
+const char* LoaStatsTable::CauseName(LoaInvalidationCause cause)
+{
+    switch (cause) {
+    case LOA_INVAL_TTL:            return "ttl";
+    case LOA_INVAL_SECTOR_CONTROL: return "sectorControl";
+    case LOA_INVAL_CONTROLLER:     return "controller";
+    case LOA_INVAL_VOLUMES:        return "volumes";
+    case LOA_INVAL_FLIGHT_PLAN:    return "flightPlan";
+    case LOA_INVAL_RELOAD:         return "reload";
+    case LOA_INVAL_RUNWAYS:        return "runways";
+    default:                       return "?";
+    }
+}
+
+static void FormatNs(char* out, size_t size, uint64_t ns)
+{
+    if (ns < 10000ULL) sprintf_s(out, size, "%llu ns", (unsigned long long)ns);
+    else if (ns < 10000000ULL) sprintf_s(out, size, "%.1f us", (double)ns / 1e3);
+    else sprintf_s(out, size, "%.1f ms", (double)ns / 1e6);
+}
+
+void LOAPlugin::ReportLoaStats()
+{
+#ifdef LOA_NO_STATS
+    DisplayUserMessage("LOA Plugin", "Stats", "Statistics are not compiled into this build (LOA_NO_STATS)",
+        true, true, false, false, false);
+#else
+    for (int i = 0; i < LOA_STAT_SITE_COUNT; ++i) {
+        const LoaStatSite site = (LoaStatSite)i;
+        const LoaLatencyHistogram& h = loaStats.sites[site];
+
+        char p50[24], p99[24], peak[24], buf[192];
+        FormatNs(p50, sizeof(p50), h.Percentile(0.50));
+        FormatNs(p99, sizeof(p99), h.Percentile(0.99));
+        FormatNs(peak, sizeof(peak), h.maxNs);
+        sprintf_s(buf, sizeof(buf), "%-17s calls %llu, p50 <%s, p99 <%s, max %s",
+            LoaStatsTable::SiteName(site), (unsigned long long)h.count, p50, p99, peak);
+        DisplayUserMessage("LOA Plugin", "Stats", buf, true, true, false, false, false);
+    }
+#endif
+}
+
+// One line per cache: hit rate first, then where the misses came from
+static void FormatCacheLine(char* out, size_t size, LoaCacheId cache, const LoaCacheCounters& c)
+{
+    const uint64_t lookups = c.hits + c.staleHits + c.misses;
+    uint64_t invalidated = 0;
+    for (uint64_t n : c.invalidations) invalidated += n;
+    const double hitPct = lookups ? 100.0 * (double)c.hits / (double)lookups : 0.0;
+
+    int len = sprintf_s(out, size, "%-17s hit %.1f%% (%llu/%llu), stale %llu, evicted %llu, invalidated %llu",
+        LoaStatsTable::CacheName(cache), hitPct,
+        (unsigned long long)c.hits, (unsigned long long)lookups,
+        (unsigned long long)c.staleHits, (unsigned long long)c.evictions, (unsigned long long)invalidated);
+    for (int k = 0; k < LOA_INVAL_COUNT && len > 0 && (size_t)len < size; ++k) {
+        if (c.invalidations[k] == 0) continue;
+        len += sprintf_s(out + len, size - (size_t)len, " %s=%llu",
+            LoaStatsTable::CauseName((LoaInvalidationCause)k), (unsigned long long)c.invalidations[k]);
+    }
+}
+
+void LOAPlugin::ReportLoaCacheStats()
+{
+#ifdef LOA_NO_STATS
+    DisplayUserMessage("LOA Plugin", "Stats", "Statistics are not compiled into this build (LOA_NO_STATS)",
+        true, true, false, false, false);
+#else
+    char buf[256];
+    for (int i = 0; i < LOA_CACHE_COUNT; ++i) {
+        FormatCacheLine(buf, sizeof(buf), (LoaCacheId)i, loaStats.caches[i]);
+        DisplayUserMessage("LOA Plugin", "Cache", buf, true, true, false, false, false);
+    }
+#endif
+}
+
+bool LOAPlugin::DumpLoaStats(const std::string& path)
+{
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    out << "site,calls,p50_ns,p99_ns,max_ns,total_ns\n";
+    for (int i = 0; i < LOA_STAT_SITE_COUNT; ++i) {
+        const LoaLatencyHistogram& h = loaStats.sites[i];
+        out << LoaStatsTable::SiteName((LoaStatSite)i) << ',' << h.count << ','
+            << h.Percentile(0.50) << ',' << h.Percentile(0.99) << ','
+            << h.maxNs << ',' << h.totalNs << '\n';
+    }
+
+    out << "\ncache,hits,misses,stale_hits,evictions";
+    for (int k = 0; k < LOA_INVAL_COUNT; ++k) out << ",inval_" << LoaStatsTable::CauseName((LoaInvalidationCause)k);
+    out << '\n';
+    for (int i = 0; i < LOA_CACHE_COUNT; ++i) {
+        const LoaCacheCounters& c = loaStats.caches[i];
+        out << LoaStatsTable::CacheName((LoaCacheId)i) << ',' << c.hits << ',' << c.misses << ','
+            << c.staleHits << ',' << c.evictions;
+        for (uint64_t n : c.invalidations) out << ',' << n;
+        out << '\n';
+    }
+    return out.good();
+}
@@ -0,0 +1,115 @@
+﻿#pragma once
+
+// =============================
+// Hot-path latency statistics (".loa stats")
+// =============================
+// One log2-bucketed histogram (nanoseconds) plus call counter per instrumented site.
+// Recording is a steady_clock read and an increment; all sites run on the EuroScope
+// thread, so no atomics. Build with LOA_NO_STATS to compile every scope out.
+
+#include <cstdint>
+#include <chrono>
+
+enum LoaStatSite : uint8_t {
+	LOA_STAT_GET_TAG_ITEM,
+	LOA_STAT_MATCH,
+	LOA_STAT_LOAD_LOAS,
+	LOA_STAT_RUNWAY_POLL,
+	LOA_STAT_OWNERSHIP_CHECK,
+	LOA_STAT_HANDOFF_POPUP,
+	LOA_STAT_SITE_COUNT
+};
+
+struct LoaLatencyHistogram {
+	// Bucket b holds samples with floor(log2(ns)) == b; 2^40 ns is ~18 minutes
+	static const int kBuckets = 41;
+
+	uint64_t count = 0;
+	uint64_t totalNs = 0;
+	uint64_t maxNs = 0;
+	uint64_t buckets[kBuckets] = {};
+
+	void Record(uint64_t ns);
+	// Upper bound (ns) of the bucket holding the p-th percentile (0..1); 0 if empty
+	uint64_t Percentile(double p) const;
+};
+
+// Accelerators whose payoff is counted (".loa stats caches")
+enum LoaCacheId : uint8_t {
+	LOA_CACHE_TAG_BUNDLE,          // FlightState::bundles (rendered tag items)
+	LOA_CACHE_MATCH,               // FlightState::matchedEntry (5 s)
+	LOA_CACHE_ROUTE,               // FlightState::routePoints (5 s)
+	LOA_CACHE_ROUTE_SET,           // FlightState::routeSet (5 s)
+	LOA_CACHE_SECTOR_RESOLUTION,   // LOAPlugin::resolvedStation
+	LOA_CACHE_ONLINE_CONTROLLERS,  // LOAPlugin::cachedOnlineControllers (60 s reconcile)
+	LOA_CACHE_VOLUME_ENTRY,        // volume entry times, per match call
+	LOA_CACHE_COUNT
+};
+
+// Why a cached value was dropped or found unusable
+enum LoaInvalidationCause : uint8_t {
+	LOA_INVAL_TTL,
+	LOA_INVAL_SECTOR_CONTROL,  // sectorControlVersion bump (ownership / LOA tables)
+	LOA_INVAL_CONTROLLER,      // a controller came online / went offline
+	LOA_INVAL_VOLUMES,         // volumes.json generation
+	LOA_INVAL_FLIGHT_PLAN,     // tag inputs / flight plan edit
+	LOA_INVAL_RELOAD,          // LOA or sector_ownership.json reload
+	LOA_INVAL_RUNWAYS,         // active runway selection changed at the flight's airport
+	LOA_INVAL_COUNT
+};
+
+struct LoaCacheCounters {
+	uint64_t hits = 0;
+	uint64_t misses = 0;        // nothing cached (cold, or dropped earlier)
+	uint64_t staleHits = 0;     // served although known to be outdated
+	uint64_t evictions = 0;     // dropped by PrunePerformanceCaches / flight release
+	uint64_t invalidations[LOA_INVAL_COUNT] = {};
+};
+
+struct LoaStatsTable {
+	LoaLatencyHistogram sites[LOA_STAT_SITE_COUNT];
+	LoaCacheCounters caches[LOA_CACHE_COUNT];
+
+	void Reset();
+	static const char* SiteName(LoaStatSite site);
+	static const char* CacheName(LoaCacheId cache);
+	static const char* CauseName(LoaInvalidationCause cause);
+};
+
+extern LoaStatsTable loaStats;
+
+class LoaStatScope {
+public:
+	explicit LoaStatScope(LoaStatSite site) : site(site), t0(std::chrono::steady_clock::now()) {}
+	~LoaStatScope() {
+		loaStats.sites[site].Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - t0).count());
+	}
+	LoaStatScope(const LoaStatScope&) = delete;
+	LoaStatScope& operator=(const LoaStatScope&) = delete;
+
+private:
+	LoaStatSite site;
+	std::chrono::steady_clock::time_point t0;
+};
+
+#define LOA_STATS_CONCAT_(a, b) a##b
+#define LOA_STATS_CONCAT(a, b) LOA_STATS_CONCAT_(a, b)
+
+#ifndef LOA_NO_STATS
+// Times the rest of the enclosing block into the given site
+#define LOA_STATS_SCOPE(site) LoaStatScope LOA_STATS_CONCAT(loaStatScope_, __LINE__)(site)
+// Cache accounting; an invalidation is counted where its cause is known
+#define LOA_CACHE_HIT(cache)                (++loaStats.caches[cache].hits)
+#define LOA_CACHE_MISS(cache)               (++loaStats.caches[cache].misses)
+#define LOA_CACHE_STALE_HIT(cache)          (++loaStats.caches[cache].staleHits)
+#define LOA_CACHE_EVICT(cache, n)           (loaStats.caches[cache].evictions += (n))
+#define LOA_CACHE_INVALIDATE(cache, cause)  (++loaStats.caches[cache].invalidations[cause])
+#else
+#define LOA_STATS_SCOPE(site) ((void)0)
+#define LOA_CACHE_HIT(cache) ((void)0)
+#define LOA_CACHE_MISS(cache) ((void)0)
+#define LOA_CACHE_STALE_HIT(cache) ((void)0)
+#define LOA_CACHE_EVICT(cache, n) ((void)0)
+#define LOA_CACHE_INVALIDATE(cache, cause) ((void)0)
+#endif
@@ -0,0 +1,240 @@
+﻿// =========================
+// File: LoaTrace.cpp
+// =========================
+// Bounded multi-producer ring (per-slot sequence numbers) drained by one flush thread
+// into Chrome trace_event JSON ("array" format: one event object per line).
+
+#include "stdafx.h"
+#include "LoaTrace.h"
+#include "LoaStats.h"
+#include <windows.h>
+#include <cstdio>
+#include <cstring>
+
+LoaTracer loaTracer;
+
+const uint32_t LoaTracer::kCapacity;
+const uint32_t LoaTracer::kFlushIntervalMs;
+
+namespace {
+    void CopyArg(char (&dst)[16], const char* src)
+    {
+        dst[0] = '\0';
+        if (src) strncpy_s(dst, sizeof(dst), src, _TRUNCATE);
+    }
+
+    // Callsigns and sector IDs never need it, but keep the file valid JSON regardless
+    std::string JsonEscape(const char* s)
+    {
+        std::string out;
+        for (; s && *s; ++s) {
+            const unsigned char c = (unsigned char)*s;
+            if (c == '"' || c == '\\') { out.push_back('\\'); out.push_back((char)c); }
+            else if (c >= 0x20) out.push_back((char)c);
+        }
+        return out;
+    }
+}
+
+LoaTracer::LoaTracer()
+    : slots(new Slot[kCapacity]), head(0), enabled(false), stopRequested(false), dropped(0)
+{
+    for (uint32_t i = 0; i < kCapacity; ++i) slots[i].seq.store(i, std::memory_order_relaxed);
+}
+
+uint64_t LoaTracer::NowUs() const
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+bool LoaTracer::Push(const LoaTraceEvent& ev)
+{
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &slots[pos & (kCapacity - 1)];
+        const uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        const int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        }
+        else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed); // full: the flush thread is behind
+            return false;
+        }
+        else {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+    slot->ev = ev;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool LoaTracer::Pop(LoaTraceEvent& ev)
+{
+    Slot& slot = slots[tail & (kCapacity - 1)];
+    const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+    if ((int64_t)(seq - (tail + 1)) < 0) return false;
+    ev = slot.ev;
+    slot.seq.store(tail + kCapacity, std::memory_order_release);
+    ++tail;
+    return true;
+}
+
+void LoaTracer::Complete(const char* category, const char* name, uint64_t tsUs, uint64_t durUs, const char* arg)
+{
+    LoaTraceEvent ev;
+    ev.name = name;
+    ev.category = category;
+    ev.phase = 'X';
+    ev.tid = (uint32_t)GetCurrentThreadId();
+    ev.tsUs = tsUs;
+    ev.durUs = durUs;
+    CopyArg(ev.arg, arg);
+    Push(ev);
+}
+
+void LoaTracer::Instant(const char* category, const char* name, const char* arg)
+{
+    LoaTraceEvent ev;
+    ev.name = name;
+    ev.category = category;
+    ev.phase = 'i';
+    ev.tid = (uint32_t)GetCurrentThreadId();
+    ev.tsUs = NowUs();
+    CopyArg(ev.arg, arg);
+    Push(ev);
+}
+
+void LoaTracer::Counter(const char* category, const char* name, const char* const* keys, const int64_t* values, int count)
+{
+    LoaTraceEvent ev;
+    ev.name = name;
+    ev.category = category;
+    ev.phase = 'C';
+    ev.tid = (uint32_t)GetCurrentThreadId();
+    ev.tsUs = NowUs();
+    for (int i = 0; i < count && i < 4; ++i) {
+        ev.keys[i] = keys[i];
+        ev.values[i] = values[i];
+    }
+    Push(ev);
+}
+
+void LoaTracer::Write(const LoaTraceEvent& ev)
+{
+    char buf[384];
+    int len = sprintf_s(buf, sizeof(buf), "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u",
+        firstEvent ? "" : ",\n", ev.name ? ev.name : "?", ev.category ? ev.category : "loa", ev.phase,
+        (unsigned long long)ev.tsUs, (unsigned)ev.tid);
+    firstEvent = false;
+    if (len < 0) return;
+    out.write(buf, len);
+
+    if (ev.phase == 'X') {
+        len = sprintf_s(buf, sizeof(buf), ",\"dur\":%llu", (unsigned long long)ev.durUs);
+        if (len > 0) out.write(buf, len);
+    }
+    if (ev.phase == 'i') out << ",\"s\":\"t\"";
+
+    if (ev.phase == 'C') {
+        out << ",\"args\":{";
+        for (int i = 0; i < 4 && ev.keys[i]; ++i) {
+            out << (i ? "," : "") << '"' << ev.keys[i] << "\":" << (long long)ev.values[i];
+        }
+        out << '}';
+    }
+    else if (ev.arg[0]) {
+        out << ",\"args\":{\"detail\":\"" << JsonEscape(ev.arg) << "\"}";
+    }
+    out << '}';
+}
+
+void LoaTracer::Drain(bool write)
+{
+    LoaTraceEvent ev;
+    while (Pop(ev)) {
+        if (write) Write(ev);
+    }
+    if (write) out.flush();
+}
+
+void LoaTracer::FlushLoop()
+{
+    while (!stopRequested.load(std::memory_order_acquire)) {
+        Drain(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kFlushIntervalMs));
+    }
+}
+
+bool LoaTracer::Start(const std::string& filePath)
+{
+    if (flusher.joinable()) return true;
+
+    out.open(filePath, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) return false;
+    path = filePath;
+
+    Drain(false); // leftovers of a previous session (their timestamps are meaningless now)
+    firstEvent = true;
+    dropped.store(0, std::memory_order_relaxed);
+    t0 = std::chrono::steady_clock::now();
+    out << "[\n";
+
+    stopRequested.store(false, std::memory_order_release);
+    try {
+        flusher = std::thread([this]() { FlushLoop(); });
+    }
+    catch (...) {
+        out.close();
+        return false;
+    }
+    enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+// The global instance is destroyed at DLL detach, under the loader lock, where joining
+// the flusher could deadlock; LOAPlugin::Shutdown() stops tracing before that
+LoaTracer::~LoaTracer()
+{
+    if (!flusher.joinable()) return;
+    enabled.store(false, std::memory_order_release);
+    stopRequested.store(true, std::memory_order_release);
+    flusher.detach();
+}
+
+void LoaTracer::Stop()
+{
+    if (!flusher.joinable()) return;
+
+    enabled.store(false, std::memory_order_release);
+    stopRequested.store(true, std::memory_order_release);
+    flusher.join();
+
+    Drain(true);
+    out << "\n]\n";
+    out.close();
+}
+
+void LoaTraceScope::SetArg(const char* value)
+{
+    CopyArg(arg, value);
+}
+
+// Cumulative cache counters as trace counters, so hit rates line up with the spans
+void LoaTraceCacheCounters()
+{
+#ifndef LOA_NO_STATS
+    if (!loaTracer.Enabled()) return;
+    static const char* const keys[4] = { "hits", "misses", "stale", "invalidated" };
+    for (int i = 0; i < LOA_CACHE_COUNT; ++i) {
+        const LoaCacheCounters& c = loaStats.caches[i];
+        uint64_t invalidated = 0;
+        for (uint64_t n : c.invalidations) invalidated += n;
+        const int64_t values[4] = { (int64_t)c.hits, (int64_t)c.misses, (int64_t)c.staleHits, (int64_t)invalidated };
+        loaTracer.Counter("cache", LoaStatsTable::CacheName((LoaCacheId)i), keys, values, 4);
+    }
+#endif
+}
@@ -0,0 +1,132 @@
+﻿#pragma once
+
+// =============================
+// Chrome trace_event export (".loa trace on|off")
+// =============================
+// Spans and counters go into a bounded lock-free ring (any thread may produce; full ring
+// drops); a background thread drains it into <plugin folder>\loa_trace.json, which
+// Perfetto / chrome://tracing open directly. While tracing is off a scope costs one
+// relaxed atomic load. LOA_NO_STATS compiles the scopes out together with the statistics.
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <fstream>
+
+struct LoaTraceEvent {
+	const char* name = nullptr;      // string literal
+	const char* category = nullptr;  // string literal
+	char phase = 'X';                // 'X' complete span, 'C' counter, 'i' instant
+	uint32_t tid = 0;
+	uint64_t tsUs = 0;               // since the tracer started
+	uint64_t durUs = 0;
+	// 'C': up to four named series; keys are string literals
+	const char* keys[4] = {};
+	int64_t values[4] = {};
+	char arg[16] = {};               // optional detail (callsign, sector), 'X'/'i' only
+};
+
+class LoaTracer {
+public:
+	static const uint32_t kCapacity = 1u << 14; // power of two
+	static const uint32_t kFlushIntervalMs = 200;
+
+	LoaTracer();
+	~LoaTracer();
+	LoaTracer(const LoaTracer&) = delete;
+	LoaTracer& operator=(const LoaTracer&) = delete;
+
+	// UI thread only
+	bool Start(const std::string& path);
+	void Stop();
+
+	bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+	uint64_t NowUs() const;
+	uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+	const std::string& Path() const { return path; }
+
+	// Any thread
+	void Complete(const char* category, const char* name, uint64_t tsUs, uint64_t durUs, const char* arg);
+	void Instant(const char* category, const char* name, const char* arg);
+	void Counter(const char* category, const char* name, const char* const* keys, const int64_t* values, int count);
+
+private:
+	struct Slot {
+		std::atomic<uint64_t> seq;
+		LoaTraceEvent ev;
+	};
+
+	bool Push(const LoaTraceEvent& ev);
+	bool Pop(LoaTraceEvent& ev);   // flush thread (or UI thread once it has stopped)
+	void Drain(bool write);
+	void FlushLoop();
+	void Write(const LoaTraceEvent& ev);
+
+	std::unique_ptr<Slot[]> slots;
+	std::atomic<uint64_t> head;    // next position producers claim
+	uint64_t tail = 0;             // consumer only
+	std::atomic<bool> enabled;
+	std::atomic<bool> stopRequested;
+	std::atomic<uint64_t> dropped;
+	std::chrono::steady_clock::time_point t0;
+	std::thread flusher;
+	std::ofstream out;
+	std::string path;
+	bool firstEvent = true;
+};
+
+extern LoaTracer loaTracer;
+
+// Emits the LoaStats cache counters as trace counters (UI thread, while tracing)
+void LoaTraceCacheCounters();
+
+class LoaTraceScope {
+public:
+	LoaTraceScope(const char* category, const char* name)
+		: category(category), name(name), active(loaTracer.Enabled()) {
+		if (active) t0 = loaTracer.NowUs();
+	}
+	~LoaTraceScope() { End(); }
+	LoaTraceScope(const LoaTraceScope&) = delete;
+	LoaTraceScope& operator=(const LoaTraceScope&) = delete;
+
+	bool Active() const { return active; }
+	void SetArg(const char* value);
+	// Closes the span early (for phases that are not a block of their own)
+	void End() {
+		if (!active) return;
+		active = false;
+		loaTracer.Complete(category, name, t0, loaTracer.NowUs() - t0, arg);
+	}
+
+private:
+	const char* category;
+	const char* name;
+	bool active;
+	uint64_t t0 = 0;
+	char arg[16] = {};
+};
+
+#ifndef LOA_NO_STATS
+#define LOA_TRACE_CONCAT_(a, b) a##b
+#define LOA_TRACE_CONCAT(a, b) LOA_TRACE_CONCAT_(a, b)
+// Span over the rest of the enclosing block
+#define LOA_TRACE_SCOPE(category, name) LoaTraceScope LOA_TRACE_CONCAT(loaTraceScope_, __LINE__)(category, name)
+// Same, with a detail string that is only evaluated while tracing
+#define LOA_TRACE_SCOPE_ARG(category, name, argExpr) \
+	LoaTraceScope LOA_TRACE_CONCAT(loaTraceScope_, __LINE__)(category, name); \
+	if (LOA_TRACE_CONCAT(loaTraceScope_, __LINE__).Active()) LOA_TRACE_CONCAT(loaTraceScope_, __LINE__).SetArg(argExpr)
+// Named span that can be closed before the block ends
+#define LOA_TRACE_BEGIN(var, category, name) LoaTraceScope var(category, name)
+#define LOA_TRACE_END(var) var.End()
+#define LOA_TRACE_INSTANT(category, name, arg) do { if (loaTracer.Enabled()) loaTracer.Instant(category, name, arg); } while (0)
+#else
+#define LOA_TRACE_SCOPE(category, name) ((void)0)
+#define LOA_TRACE_SCOPE_ARG(category, name, argExpr) ((void)0)
+#define LOA_TRACE_BEGIN(var, category, name) ((void)0)
+#define LOA_TRACE_END(var) ((void)0)
+#define LOA_TRACE_INSTANT(category, name, arg) ((void)0)
+#endif
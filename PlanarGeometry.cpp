@@ -0,0 +1,320 @@
+﻿// =========================
+// File: PlanarGeometry.cpp
+// =========================
+// Stereographic projection of lat/lon into the local FIR plane, plus exact
+// orientation-based predicates for volume and sector polygons.
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+    const double kPi = 3.14159265358979323846;
+    const double kDegToRad = kPi / 180.0;
+    const double kEarthRadiusM = 6371008.8; // mean earth radius
+
+    // |coordinate| <= 2^30 - 1, so a difference stays under 2^31, a product of two
+    // differences under 2^62, and a difference of two products under 2^63.
+    const double kMaxPlanarCoord = 1073741823.0;
+
+    static int32_t RoundToInt32(double v)
+    {
+        // FIR-sized planes are a few thousand km across; clamp anyway so a bad
+        // coordinate can never overflow the integer predicates.
+        if (v > kMaxPlanarCoord) v = kMaxPlanarCoord;
+        if (v < -kMaxPlanarCoord) v = -kMaxPlanarCoord;
+        return (int32_t)std::floor(v + 0.5);
+    }
+}
+
+void PlanarProjection::SetAnchor(double lat, double lon)
+{
+    anchorLat = lat;
+    anchorLon = lon;
+    sinAnchorLat = std::sin(lat * kDegToRad);
+    cosAnchorLat = std::cos(lat * kDegToRad);
+    valid = true;
+}
+
+PlanarPoint PlanarProjection::Project(double lat, double lon) const
+{
+    // Spherical stereographic projection: conformal, so shapes and crossing
+    // order are preserved around the anchor without the lat/lon shear.
+    const double phi = lat * kDegToRad;
+    const double dLambda = (lon - anchorLon) * kDegToRad;
+    const double sinPhi = std::sin(phi);
+    const double cosPhi = std::cos(phi);
+    const double cosDLambda = std::cos(dLambda);
+
+    double denom = 1.0 + sinAnchorLat * sinPhi + cosAnchorLat * cosPhi * cosDLambda;
+    if (denom < 1e-9) denom = 1e-9; // antipode of the anchor; never inside a FIR
+
+    const double k = 2.0 * kEarthRadiusM / denom;
+
+    PlanarPoint p;
+    p.x = RoundToInt32(k * cosPhi * std::sin(dLambda));
+    p.y = RoundToInt32(k * (cosAnchorLat * sinPhi - sinAnchorLat * cosPhi * cosDLambda));
+    return p;
+}
+
+int OrientPlanar(const PlanarPoint& a, const PlanarPoint& b, const PlanarPoint& c)
+{
+    // Cross product of AB x AC. Coordinates are clamped to +-(2^30 - 1) at projection,
+    // so each product is below 2^62 and their difference fits in int64: exact.
+    const int64_t v =
+        (int64_t)(b.x - (int64_t)a.x) * (int64_t)(c.y - (int64_t)a.y) -
+        (int64_t)(b.y - (int64_t)a.y) * (int64_t)(c.x - (int64_t)a.x);
+    if (v > 0) return 1;
+    if (v < 0) return -1;
+    return 0;
+}
+
+static bool OnSegmentPlanar(const PlanarPoint& a, const PlanarPoint& b, const PlanarPoint& c)
+{
+    // Assumes a, b, c are collinear
+    const int32_t minx = (a.x < b.x ? a.x : b.x);
+    const int32_t maxx = (a.x > b.x ? a.x : b.x);
+    const int32_t miny = (a.y < b.y ? a.y : b.y);
+    const int32_t maxy = (a.y > b.y ? a.y : b.y);
+    return (minx <= c.x && c.x <= maxx) && (miny <= c.y && c.y <= maxy);
+}
+
+bool PointInPlanarPolygon(const PlanarPoint& p, const std::vector<PlanarPoint>& poly)
+{
+    const size_t n = poly.size();
+    if (n < 3) return false;
+
+    // Crossing-number test with the edge/ray intersection decided by orientation
+    // instead of a divided slope, so there is no epsilon and no division.
+    bool inside = false;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        const PlanarPoint& pi = poly[i];
+        const PlanarPoint& pj = poly[j];
+        if ((pi.y > p.y) == (pj.y > p.y)) continue;
+
+        // Edge pi->pj straddles the horizontal through p. The crossing lies to the
+        // right of p exactly when p is on the left of the upward-directed edge.
+        const int o = OrientPlanar(pi, pj, p);
+        const bool crossesRight = (pj.y > pi.y) ? (o > 0) : (o < 0);
+        if (crossesRight) inside = !inside;
+    }
+    return inside;
+}
+
+static bool SegmentsIntersectPlanar(const PlanarPoint& a, const PlanarPoint& b,
+    const PlanarPoint& c, const PlanarPoint& d)
+{
+    const int o1 = OrientPlanar(a, b, c);
+    const int o2 = OrientPlanar(a, b, d);
+    const int o3 = OrientPlanar(c, d, a);
+    const int o4 = OrientPlanar(c, d, b);
+
+    if (o1 != o2 && o3 != o4) return true;
+
+    // Collinear cases
+    if (o1 == 0 && OnSegmentPlanar(a, b, c)) return true;
+    if (o2 == 0 && OnSegmentPlanar(a, b, d)) return true;
+    if (o3 == 0 && OnSegmentPlanar(c, d, a)) return true;
+    if (o4 == 0 && OnSegmentPlanar(c, d, b)) return true;
+
+    return false;
+}
+
+bool SegmentIntersectsPlanarPolygon(const PlanarPoint& a, const PlanarPoint& b, const std::vector<PlanarPoint>& poly)
+{
+    const size_t n = poly.size();
+    if (n < 2) return false;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        if (SegmentsIntersectPlanar(a, b, poly[j], poly[i]))
+            return true;
+    }
+    return false;
+}
+
+// ---------------- PlanarGridIndex ----------------
+
+void PlanarGridIndex::Clear()
+{
+    originX = 0;
+    originY = 0;
+    cellSize = 1;
+    cols = 0;
+    rows = 0;
+    cellStart.clear();
+    items.clear();
+}
+
+void PlanarGridIndex::Build(const std::vector<PlanarPoint>& boundsMin, const std::vector<PlanarPoint>& boundsMax, int32_t cellSizeM)
+{
+    Clear();
+    const size_t n = boundsMin.size();
+    if (n == 0 || boundsMax.size() != n) return;
+
+    int64_t minX = boundsMin[0].x, minY = boundsMin[0].y;
+    int64_t maxX = boundsMax[0].x, maxY = boundsMax[0].y;
+    for (size_t i = 1; i < n; ++i) {
+        if (boundsMin[i].x < minX) minX = boundsMin[i].x;
+        if (boundsMin[i].y < minY) minY = boundsMin[i].y;
+        if (boundsMax[i].x > maxX) maxX = boundsMax[i].x;
+        if (boundsMax[i].y > maxY) maxY = boundsMax[i].y;
+    }
+
+    // Keep the cell table bounded even for odd inputs (e.g. a stray far-away polygon).
+    const int64_t kMaxCells = 1 << 16;
+    int64_t size = (cellSizeM > 0) ? cellSizeM : 25000;
+    for (;;) {
+        const int64_t c = (maxX - minX) / size + 1;
+        const int64_t r = (maxY - minY) / size + 1;
+        if (c * r <= kMaxCells) {
+            cols = (int32_t)c;
+            rows = (int32_t)r;
+            break;
+        }
+        size *= 2;
+    }
+    originX = minX;
+    originY = minY;
+    cellSize = size;
+
+    auto cellRange = [&](size_t i, int32_t& c0, int32_t& c1, int32_t& r0, int32_t& r1) {
+        c0 = (int32_t)((boundsMin[i].x - originX) / cellSize);
+        c1 = (int32_t)((boundsMax[i].x - originX) / cellSize);
+        r0 = (int32_t)((boundsMin[i].y - originY) / cellSize);
+        r1 = (int32_t)((boundsMax[i].y - originY) / cellSize);
+        };
+
+    // Pass 1: count, pass 2: fill
+    cellStart.assign((size_t)cols * (size_t)rows + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        int32_t c0, c1, r0, r1;
+        cellRange(i, c0, c1, r0, r1);
+        for (int32_t r = r0; r <= r1; ++r)
+            for (int32_t c = c0; c <= c1; ++c)
+                ++cellStart[(size_t)r * cols + c + 1];
+    }
+    for (size_t k = 1; k < cellStart.size(); ++k)
+        cellStart[k] += cellStart[k - 1];
+
+    items.assign(cellStart.back(), 0);
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        int32_t c0, c1, r0, r1;
+        cellRange(i, c0, c1, r0, r1);
+        for (int32_t r = r0; r <= r1; ++r)
+            for (int32_t c = c0; c <= c1; ++c)
+                items[fill[(size_t)r * cols + c]++] = (uint32_t)i;
+    }
+}
+
+const uint32_t* PlanarGridIndex::Query(const PlanarPoint& p, size_t& outCount) const
+{
+    outCount = 0;
+    if (items.empty()) return nullptr;
+
+    const int64_t dx = (int64_t)p.x - originX;
+    const int64_t dy = (int64_t)p.y - originY;
+    if (dx < 0 || dy < 0) return nullptr;
+
+    const int64_t c = dx / cellSize;
+    const int64_t r = dy / cellSize;
+    if (c >= cols || r >= rows) return nullptr;
+
+    const size_t cell = (size_t)r * cols + (size_t)c;
+    outCount = cellStart[cell + 1] - cellStart[cell];
+    return outCount ? &items[cellStart[cell]] : nullptr;
+}
+
+// ---------------- AltitudeBandIndex ----------------
+
+void AltitudeBandIndex::Clear()
+{
+    edges.clear();
+    slabStart.clear();
+    items.clear();
+}
+
+void AltitudeBandIndex::Build(const std::vector<double>& lowerFt, const std::vector<double>& upperFt)
+{
+    Clear();
+    const size_t n = lowerFt.size();
+    if (n == 0 || upperFt.size() != n) return;
+
+    edges.reserve(n * 2);
+    for (size_t i = 0; i < n; ++i) {
+        if (lowerFt[i] > upperFt[i]) continue; // inverted band never matches
+        edges.push_back(lowerFt[i]);
+        edges.push_back(upperFt[i]);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    if (edges.empty()) return;
+
+    // Slab 2k is the edge value itself, slab 2k+1 the open span (edges[k], edges[k+1]).
+    // Interval [lo, hi] therefore covers slabs 2*idx(lo) .. 2*idx(hi).
+    auto edgeIndex = [&](double v) -> size_t {
+        return (size_t)(std::lower_bound(edges.begin(), edges.end(), v) - edges.begin());
+        };
+
+    const size_t slabs = edges.size() * 2 - 1;
+    slabStart.assign(slabs + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (lowerFt[i] > upperFt[i]) continue;
+        const size_t s0 = edgeIndex(lowerFt[i]) * 2;
+        const size_t s1 = edgeIndex(upperFt[i]) * 2;
+        for (size_t s = s0; s <= s1; ++s)
+            ++slabStart[s + 1];
+    }
+    for (size_t k = 1; k < slabStart.size(); ++k)
+        slabStart[k] += slabStart[k - 1];
+
+    items.assign(slabStart.back(), 0);
+    std::vector<uint32_t> fill(slabStart.begin(), slabStart.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        if (lowerFt[i] > upperFt[i]) continue;
+        const size_t s0 = edgeIndex(lowerFt[i]) * 2;
+        const size_t s1 = edgeIndex(upperFt[i]) * 2;
+        for (size_t s = s0; s <= s1; ++s)
+            items[fill[s]++] = (uint32_t)i;
+    }
+}
+
+const uint32_t* AltitudeBandIndex::Query(double altFt, size_t& outCount) const
+{
+    outCount = 0;
+    if (items.empty()) return nullptr;
+
+    const size_t m = edges.size();
+    const size_t k = (size_t)(std::lower_bound(edges.begin(), edges.end(), altFt) - edges.begin());
+
+    size_t slab;
+    if (k < m && edges[k] == altFt) slab = k * 2;
+    else if (k == 0 || k == m) return nullptr; // below the lowest / above the highest band
+    else slab = k * 2 - 1;
+
+    outCount = slabStart[slab + 1] - slabStart[slab];
+    return outCount ? &items[slabStart[slab]] : nullptr;
+}
+
+void AltitudeBandIndex::QueryRange(double loFt, double hiFt, std::vector<uint32_t>& out) const
+{
+    out.clear();
+    if (items.empty() || !(loFt <= hiFt)) return;
+
+    const size_t m = edges.size();
+
+    // First slab at or above loFt
+    const size_t kLo = (size_t)(std::lower_bound(edges.begin(), edges.end(), loFt) - edges.begin());
+    if (kLo == m) return;
+    const size_t s0 = (edges[kLo] == loFt || kLo == 0) ? kLo * 2 : kLo * 2 - 1;
+
+    // Last slab at or below hiFt
+    const size_t kHi = (size_t)(std::upper_bound(edges.begin(), edges.end(), hiFt) - edges.begin());
+    if (kHi == 0) return;
+    const size_t s1 = (edges[kHi - 1] == hiFt || kHi == m) ? (kHi - 1) * 2 : (kHi - 1) * 2 + 1;
+
+    if (s0 > s1) return;
+    out.assign(items.begin() + slabStart[s0], items.begin() + slabStart[s1 + 1]);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
@@ -0,0 +1,102 @@
+﻿// =========================
+// File: RunwayTable.cpp
+// =========================
+// Interned airports / runway designators and the active runway bitsets per airport.
+// IDs are never reused or cleared, so masks computed from LOA runway lists stay valid
+// across sector file changes.
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include "LoaMemory.h"
+#include "LoaNames.h"
+
+const uint16_t RunwayTable::kNone;
+const uint16_t RunwayTable::kMaxRunways;
+
+namespace {
+    static const RunwayMask kNoRunways;
+}
+
+uint16_t RunwayTable::InternAirport(const char* icao)
+{
+    std::string key = LoaNameKey(icao);
+    if (key.empty()) return kNone;
+    auto it = airportIds.find(key);
+    if (it != airportIds.end()) return it->second;
+    if (airportNames.size() >= kNone) return kNone;
+
+    const uint16_t id = (uint16_t)airportNames.size();
+    airportIds.emplace(key, id);
+    airportNames.push_back(std::move(key));
+    activeDep.emplace_back();
+    activeArr.emplace_back();
+    return id;
+}
+
+uint16_t RunwayTable::InternRunway(const char* designator)
+{
+    std::string key = LoaNameKey(designator);
+    if (key.empty()) return kNone;
+    auto it = runwayIds.find(key);
+    if (it != runwayIds.end()) return it->second;
+    if (runwayNames.size() >= kMaxRunways) return kNone;
+
+    const uint16_t id = (uint16_t)runwayNames.size();
+    runwayIds.emplace(key, id);
+    runwayNames.push_back(std::move(key));
+    return id;
+}
+
+uint16_t RunwayTable::AirportId(const std::string& icao) const
+{
+    return FindInternedId(airportIds, icao, kNone);
+}
+
+const RunwayMask& RunwayTable::Active(uint16_t airport, bool departure) const
+{
+    if (airport >= airportNames.size()) return kNoRunways;
+    return departure ? activeDep[airport] : activeArr[airport];
+}
+
+void RunwayTable::BeginScan()
+{
+    scanDep.assign(airportNames.size(), RunwayMask());
+    scanArr.assign(airportNames.size(), RunwayMask());
+}
+
+void RunwayTable::MarkActive(uint16_t airport, uint16_t runway, bool departure)
+{
+    if (airport == kNone || runway == kNone) return;
+    // Airports interned during the scan
+    if (airport >= scanDep.size()) {
+        scanDep.resize(airportNames.size());
+        scanArr.resize(airportNames.size());
+    }
+    (departure ? scanDep : scanArr)[airport].Set(runway);
+}
+
+bool RunwayTable::CommitScan(std::vector<uint8_t>& changed)
+{
+    scanDep.resize(airportNames.size());
+    scanArr.resize(airportNames.size());
+    changed.assign(airportNames.size(), 0);
+
+    bool any = false;
+    for (size_t a = 0; a < airportNames.size(); ++a) {
+        if (scanDep[a] != activeDep[a]) { changed[a] |= CHANGED_DEP; any = true; }
+        if (scanArr[a] != activeArr[a]) { changed[a] |= CHANGED_ARR; any = true; }
+    }
+    if (any) {
+        activeDep.swap(scanDep);
+        activeArr.swap(scanArr);
+    }
+    return any;
+}
+
+size_t RunwayTable::FootprintBytes() const
+{
+    return LoaMemory::StringKeyedMap(airportIds) + LoaMemory::Strings(airportNames) +
+        LoaMemory::StringKeyedMap(runwayIds) + LoaMemory::Strings(runwayNames) +
+        LoaMemory::Vector(activeDep) + LoaMemory::Vector(activeArr) +
+        LoaMemory::Vector(scanDep) + LoaMemory::Vector(scanArr);
+}
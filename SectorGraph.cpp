@@ -0,0 +1,99 @@
+﻿// =========================
+// File: SectorGraph.cpp
+// =========================
+// Compiled sector_ownership.json: dense IDs, ownership bit matrix and priority ranks.
+// Names from "ownership" and "priority" (keys and list entries) share one ID space,
+// because a priority list names stations and a station is itself a sector ID.
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include "LoaMemory.h"
+#include "LoaNames.h"
+
+const uint16_t SectorGraph::kNone;
+const uint8_t SectorGraph::kUnranked;
+
+void SectorGraph::Clear()
+{
+    ids.clear();
+    names.clear();
+    defined.clear();
+    ownBits.clear();
+    wordsPerRow = 0;
+    rank.clear();
+    priority.clear();
+}
+
+size_t SectorGraph::FootprintBytes() const
+{
+    size_t bytes = LoaMemory::StringKeyedMap(ids) + LoaMemory::Strings(names) +
+        LoaMemory::Vector(defined) + LoaMemory::Vector(ownBits) + LoaMemory::Vector(rank) +
+        LoaMemory::Vector(priority);
+    for (const auto& p : priority) bytes += LoaMemory::Vector(p);
+    return bytes;
+}
+
+uint16_t SectorGraph::Intern(const std::string& name)
+{
+    const std::string key = LoaNameKey(name);
+    auto it = ids.find(key);
+    if (it != ids.end()) return it->second;
+    if (names.size() >= kNone) return kNone;
+
+    const uint16_t id = (uint16_t)names.size();
+    ids.emplace(key, id);
+    names.push_back(name);
+    return id;
+}
+
+uint16_t SectorGraph::Id(const std::string& name) const
+{
+    return FindInternedId(ids, name, kNone);
+}
+
+void SectorGraph::Build(const std::unordered_map<std::string, std::vector<std::string>>& ownership,
+    const std::unordered_map<std::string, std::vector<std::string>>& priorityLists)
+{
+    Clear();
+
+    for (const auto& kv : ownership) {
+        Intern(kv.first);
+        for (const auto& s : kv.second) Intern(s);
+    }
+    for (const auto& kv : priorityLists) {
+        Intern(kv.first);
+        for (const auto& s : kv.second) Intern(s);
+    }
+
+    const size_t n = names.size();
+    defined.assign(n, 0);
+    wordsPerRow = (n + 63) / 64;
+    ownBits.assign(n * wordsPerRow, 0ULL);
+    rank.assign(n * n, kUnranked);
+    priority.assign(n, std::vector<uint16_t>());
+
+    for (const auto& kv : ownership) {
+        const uint16_t station = Id(kv.first);
+        if (station == kNone) continue;
+        defined[station] = 1;
+        for (const auto& s : kv.second) {
+            const uint16_t sector = Id(s);
+            if (sector == kNone) continue;
+            ownBits[station * wordsPerRow + (sector >> 6)] |= 1ULL << (sector & 63);
+        }
+    }
+
+    for (const auto& kv : priorityLists) {
+        const uint16_t sector = Id(kv.first);
+        if (sector == kNone) continue;
+        std::vector<uint16_t>& list = priority[sector];
+        for (const auto& s : kv.second) {
+            const uint16_t station = Id(s);
+            if (station == kNone) continue;
+            list.push_back(station);
+            // First occurrence wins (like std::find); deeper than 254 counts as unranked
+            uint8_t& r = rank[(size_t)sector * n + station];
+            if (r == kUnranked && list.size() < kUnranked) r = (uint8_t)(list.size() - 1);
+        }
+    }
+}
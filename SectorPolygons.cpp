@@ -0,0 +1,331 @@
+﻿// =========================
+// File: SectorPolygons.cpp
+// =========================
+// Sector-file polygon index for route-based next sectors.
+// ARTCC/airspace boundaries mapped in sector_ownership.json are projected into the volume
+// plane once per sector-file load, so predicted sector sequences come from one local sweep
+// over the trajectory. Points outside every mapped sector fall back to EuroScope.
+
+#include "stdafx.h"
+#include "LOAPlugin.h"
+#include "LoaNames.h"
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+    const int32_t kSectorGridCellM = 25000;
+    const ULONGLONG kSectorFileCheckIntervalMs = 30000ULL;
+    const int kMaxElementPoints = 20000;
+
+    // Element types that can carry sector outlines; which elements are used is
+    // decided by name through sectorPolygonSources, not by type.
+    static const int kPolygonElementTypes[] = {
+        EuroScopePlugIn::SECTOR_ELEMENT_HIGH_ARTC,
+        EuroScopePlugIn::SECTOR_ELEMENT_ARTC,
+        EuroScopePlugIn::SECTOR_ELEMENT_LOW_ARTC,
+        EuroScopePlugIn::SECTOR_ELEMENT_AIRSPACE,
+    };
+
+    struct PlanarSegment {
+        PlanarPoint a;
+        PlanarPoint b;
+    };
+
+    static bool SamePoint(const PlanarPoint& a, const PlanarPoint& b)
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    static uint64_t PointKey(const PlanarPoint& p)
+    {
+        return ((uint64_t)(uint32_t)p.x << 32) | (uint64_t)(uint32_t)p.y;
+    }
+
+    // Joins segments end to end into closed rings, in whatever order the sector file
+    // lists them. Fails (no rings) if any endpoint is left open: such an element does
+    // not describe an outline and a point-in-polygon test on it would be meaningless.
+    static bool StitchRings(const std::vector<PlanarSegment>& segs,
+        std::vector<std::vector<PlanarPoint>>& rings)
+    {
+        rings.clear();
+
+        std::unordered_map<uint64_t, std::vector<uint32_t>> incident;
+        for (uint32_t k = 0; k < (uint32_t)segs.size(); ++k) {
+            incident[PointKey(segs[k].a)].push_back(k);
+            incident[PointKey(segs[k].b)].push_back(k);
+        }
+        // Closed rings touch every vertex an even number of times
+        for (const auto& kv : incident) {
+            if (kv.second.size() % 2 != 0) return false;
+        }
+
+        std::vector<uint8_t> used(segs.size(), 0);
+        for (uint32_t first = 0; first < (uint32_t)segs.size(); ++first) {
+            if (used[first]) continue;
+            used[first] = 1;
+
+            std::vector<PlanarPoint> ring;
+            const PlanarPoint start = segs[first].a;
+            PlanarPoint cur = segs[first].b;
+            ring.push_back(start);
+
+            // With even degrees every walk returns to its start
+            while (!SamePoint(cur, start)) {
+                ring.push_back(cur);
+                uint32_t next = (uint32_t)segs.size();
+                for (uint32_t k : incident[PointKey(cur)]) {
+                    if (!used[k]) { next = k; break; }
+                }
+                if (next == (uint32_t)segs.size()) return false;
+                used[next] = 1;
+                cur = SamePoint(segs[next].a, cur) ? segs[next].b : segs[next].a;
+            }
+
+            // A segment listed twice closes as a two-point "ring"; it has no area
+            if (ring.size() >= 3) rings.push_back(std::move(ring));
+        }
+        return !rings.empty();
+    }
+}
+
+bool LOAPlugin::IsPointInsidePolygon(const PlanarPoint& p,
+    const SectorPolygon& poly) const
+{
+    if (p.x < poly.boundsMin.x || p.x > poly.boundsMax.x ||
+        p.y < poly.boundsMin.y || p.y > poly.boundsMax.y)
+        return false;
+    return PointInPlanarPolygon(p, poly.pts);
+}
+
+void LOAPlugin::EnsureSectorPolygonIndex()
+{
+    const ULONGLONG nowMs = GetTickCount64();
+    if (!sectorPolygonsDirty && nowMs - lastSectorFileCheckMs < kSectorFileCheckIntervalMs)
+        return;
+    lastSectorFileCheckMs = nowMs;
+
+    // There is no "sector file loaded" callback: fingerprint element names, plus the
+    // coordinates of the mapped elements, and rebuild only when the sector file changed.
+    unsigned long long h = 1469598103934665603ULL;
+    auto mix = [&h](const void* data, size_t len) {
+        const unsigned char* b = (const unsigned char*)data;
+        for (size_t k = 0; k < len; ++k) {
+            h ^= b[k];
+            h *= 1099511628211ULL;
+        }
+        };
+    for (const int type : kPolygonElementTypes) {
+        for (EuroScopePlugIn::CSectorElement sfe = SectorFileElementSelectFirst(type);
+            sfe.IsValid();
+            sfe = SectorFileElementSelectNext(sfe, type))
+        {
+            const char* name = sfe.GetName();
+            if (name) mix(name, strlen(name));
+            const unsigned char typeTag = (unsigned char)('0' + type);
+            mix(&typeTag, 1);
+
+            if (!sectorPolygonSources.count(LoaNameKey(name))) continue;
+            EuroScopePlugIn::CPosition pos;
+            for (int idx = 0; idx < kMaxElementPoints && sfe.GetPosition(&pos, idx); ++idx) {
+                mix(&pos.m_Latitude, sizeof(pos.m_Latitude));
+                mix(&pos.m_Longitude, sizeof(pos.m_Longitude));
+            }
+        }
+    }
+
+    if (!sectorPolygonsDirty && h == sectorFileFingerprint)
+        return;
+
+    sectorFileFingerprint = h;
+    sectorPolygonsDirty = false;
+    LoadSectorPolygonsFromSectorFile();
+}
+
+void LOAPlugin::LoadSectorPolygonsFromSectorFile()
+{
+    sectorPolygons.clear();
+    sectorPolygonGrid.Clear();
+
+    if (sectorPolygonSources.empty()) return;
+
+    struct ParsedElement {
+        const SectorPolygonSource* source;
+        bool segmentPairs;                           // ARTCC: unordered (from, to) pairs
+        std::vector<EuroScopePlugIn::CPosition> pts;
+    };
+    std::vector<ParsedElement> parsed;
+    double latSum = 0.0;
+    double lonSum = 0.0;
+    size_t pointCount = 0;
+
+    for (const int type : kPolygonElementTypes) {
+        for (EuroScopePlugIn::CSectorElement sfe = SectorFileElementSelectFirst(type);
+            sfe.IsValid();
+            sfe = SectorFileElementSelectNext(sfe, type))
+        {
+            // Exact (case-folded) element name only; unmapped elements are left to EuroScope
+            const auto src = sectorPolygonSources.find(LoaNameKey(sfe.GetName()));
+            if (src == sectorPolygonSources.end()) continue;
+
+            std::vector<EuroScopePlugIn::CPosition> pts;
+            EuroScopePlugIn::CPosition pos;
+            for (int idx = 0; idx < kMaxElementPoints && sfe.GetPosition(&pos, idx); ++idx) {
+                pts.push_back(pos);
+            }
+            if (pts.size() < 3) continue;
+
+            // ARTCC entries are line segments, two positions each; AIRSPACE outlines are
+            // an ordered vertex list. Either way the outline has to close by itself.
+            const bool segmentPairs = (type != EuroScopePlugIn::SECTOR_ELEMENT_AIRSPACE);
+            if (segmentPairs && pts.size() % 2 != 0) continue;
+
+            for (const auto& p : pts) {
+                latSum += p.m_Latitude;
+                lonSum += p.m_Longitude;
+            }
+            pointCount += pts.size();
+
+            ParsedElement element;
+            element.source = &src->second;
+            element.segmentPairs = segmentPairs;
+            element.pts = std::move(pts);
+            parsed.push_back(std::move(element));
+        }
+    }
+
+    if (parsed.empty()) return;
+
+    // Share the volume plane; only anchor here when volumes.json gave no anchor.
+    if (!planarProjection.valid) {
+        planarProjection.SetAnchor(latSum / (double)pointCount, lonSum / (double)pointCount);
+    }
+
+    std::vector<PlanarPoint> boundsMin;
+    std::vector<PlanarPoint> boundsMax;
+    sectorPolygons.reserve(parsed.size());
+
+    std::vector<PlanarPoint> projected;
+    std::vector<PlanarSegment> segs;
+    std::vector<std::vector<PlanarPoint>> rings;
+    int openElements = 0;
+
+    for (const ParsedElement& element : parsed) {
+        projected.clear();
+        for (const auto& ll : element.pts) {
+            projected.push_back(planarProjection.Project(ll.m_Latitude, ll.m_Longitude));
+        }
+
+        segs.clear();
+        const size_t step = element.segmentPairs ? 2 : 1;
+        for (size_t k = 0; k + 1 < projected.size(); k += step) {
+            if (SamePoint(projected[k], projected[k + 1])) continue;
+            segs.push_back({ projected[k], projected[k + 1] });
+        }
+
+        if (!StitchRings(segs, rings)) {
+            ++openElements;
+            continue;
+        }
+
+        for (std::vector<PlanarPoint>& ring : rings) {
+            SectorPolygon poly;
+            poly.sectorId = element.source->sectorId;
+            poly.lowerFt = element.source->lowerFt;
+            poly.upperFt = element.source->upperFt;
+            poly.pts = std::move(ring);
+
+            poly.boundsMin = poly.pts.front();
+            poly.boundsMax = poly.pts.front();
+            for (const PlanarPoint& p : poly.pts) {
+                if (p.x < poly.boundsMin.x) poly.boundsMin.x = p.x;
+                if (p.y < poly.boundsMin.y) poly.boundsMin.y = p.y;
+                if (p.x > poly.boundsMax.x) poly.boundsMax.x = p.x;
+                if (p.y > poly.boundsMax.y) poly.boundsMax.y = p.y;
+            }
+
+            boundsMin.push_back(poly.boundsMin);
+            boundsMax.push_back(poly.boundsMax);
+            sectorPolygons.push_back(std::move(poly));
+        }
+    }
+
+    sectorPolygonGrid.Build(boundsMin, boundsMax, kSectorGridCellM);
+
+    char buf[128];
+    sprintf_s(buf, sizeof(buf), "Sector polygons indexed: %d (%d unclosed elements skipped)",
+        (int)sectorPolygons.size(), openElements);
+    DisplayUserMessage("LOA Plugin", "Sector File", buf, true, false, false, false, false);
+}
+
+const SectorPolygon* LOAPlugin::FindSectorPolygonAt(const PlanarPoint& p, double altFt) const
+{
+    size_t count = 0;
+    const uint32_t* idx = sectorPolygonGrid.Query(p, count);
+    for (size_t k = 0; k < count; ++k) {
+        const SectorPolygon& poly = sectorPolygons[idx[k]];
+        // Closed [lowerFt, upperFt], like custom volumes (InVolumeBand)
+        if (altFt < poly.lowerFt || altFt > poly.upperFt) continue;
+        if (IsPointInsidePolygon(p, poly)) return &poly;
+    }
+    return nullptr;
+}
+
+std::vector<std::string> LOAPlugin::GetPredictedControllerSequence(
+    const EuroScopePlugIn::CFlightPlan& fp)
+{
+    std::vector<std::string> result;
+
+    EuroScopePlugIn::CFlightPlanPositionPredictions preds = fp.GetPositionPredictions();
+    const int n = preds.GetPointsNumber();
+    if (n <= 0) return result;
+
+    EnsureSectorPolygonIndex();
+    const bool useLocalIndex = !sectorPolygonGrid.Empty() && planarProjection.valid;
+
+    // Consecutive points usually sit in the same sector: resolve the station once per sector run.
+    const SectorPolygon* lastPoly = nullptr;
+    std::string lastPolyStation;
+    std::string lastStation;
+
+    for (int i = 0; i < n; ++i) {
+        std::string station;
+
+        const SectorPolygon* poly = nullptr;
+        if (useLocalIndex) {
+            const EuroScopePlugIn::CPosition pos = preds.GetPosition(i);
+            poly = FindSectorPolygonAt(planarProjection.Project(pos.m_Latitude, pos.m_Longitude),
+                ToAltFeet(preds.GetAltitude(i)));
+        }
+
+        if (poly) {
+            if (poly != lastPoly) {
+                lastPoly = poly;
+                lastPolyStation = ResolveControllingSector(poly->sectorId);
+            }
+            station = lastPolyStation;
+        }
+        else {
+            lastPoly = nullptr;
+        }
+
+        // No configured sector at this point and level, or nobody online for it:
+        // EuroScope's own prediction decides.
+        if (station.empty()) {
+            const char* id = preds.GetControllerId(i);
+            if (id) station = id;
+        }
+
+        if (station.empty()) continue;
+
+        // Skip consecutive repeats
+        if (!lastStation.empty() && _stricmp(station.c_str(), lastStation.c_str()) == 0)
+            continue;
+
+        lastStation = station;
+        result.push_back(station);
+    }
+
+    return result;
+}
@@ -3,18 +3,8 @@
 #include <string>
 #include <cstring>
 #include <windows.h>
-#include <unordered_map>
 
 namespace {
-    struct CopHeuristicState {
-        std::string baselineValue;
-        std::string pendingValue;
-        bool hasBaseline = false;
-        bool pendingActive = false;
-    };
-
-    static std::unordered_map<std::string, CopHeuristicState> g_copHeuristic;
-
     static bool EqualsNoCase(const std::string& a, const std::string& b)
     {
         return _stricmp(a.c_str(), b.c_str()) == 0;
@@ -39,28 +29,29 @@ void RenderCOPTagItem(
 {
     const bool isListContext = !radarTarget.IsValid();
 
-    if (!flightPlan.IsValid() || !plugin.IsLOARelevantState(flightPlan.GetState())) {
+    if (!flightPlan.IsValid() || !pMyPlugIn->IsLOARelevantState(flightPlan.GetState())) {
         strncpy_s(sItemString, 16, "COPX", _TRUNCATE);
         return;
     }
 
-    const std::string callsign = flightPlan.GetCallsign();
+    // Learned baseline/pending values live in the flight's FlightState record
+    FlightState& flight = pMyPlugIn->GetFlightState(flightPlan);
 
     if (flightPlan.GetState() == FLIGHT_PLAN_STATE_NON_CONCERNED) {
-        g_copHeuristic.erase(callsign);
+        flight.cop = CopHeuristicState();
         strncpy_s(sItemString, 16, "COPX", _TRUNCATE);
         return;
     }
 
     const auto& fpd = flightPlan.GetFlightPlanData();
     if (_stricmp(fpd.GetPlanType(), "I") != 0) {
-        g_copHeuristic.erase(callsign);
+        flight.cop = CopHeuristicState();
         strncpy_s(sItemString, 16, "COPX", _TRUNCATE);
         return;
     }
 
-    const LOAEntry* matched = plugin.currentFrameMatchedEntry;
-    if (matched && !plugin.IsLoaEntryPointerValid(matched)) matched = nullptr;
+    const LOAEntry* matched = ctx.matchedEntry;
+    if (matched && !pMyPlugIn->IsLoaEntryPointerValid(matched)) matched = nullptr;
 
     auto showFallback = [&]() {
         if (matched && !matched->copText.empty() && _stricmp(matched->copText.c_str(), "COPX") != 0) {
@@ -73,7 +64,7 @@ void RenderCOPTagItem(
 
     const std::string coordCOP = flightPlan.GetExitCoordinationPointName();
     const int coordState = flightPlan.GetExitCoordinationNameState();
-    CopHeuristicState& st = g_copHeuristic[callsign];
+    CopHeuristicState& st = flight.cop;
 
     // Explicit refusal: abandon the pending request and fall back immediately.
     if (coordState == COORDINATION_STATE_REFUSED) {
@@ -66,7 +66,8 @@ void RenderNextSectorTagItem(
         };
 
     // ✅ Check Departure LOAs
-    for (const auto& entry : departureLoas) {
+    for (const LOAEntry* pe : departureLoas) {
+        const LOAEntry& entry = *pe;
         if (matches(entry)) {
             if ((clearedAltitude < entry.xfl * 100 && finalAltitude > entry.xfl * 100) ||
                 (clearedAltitude > entry.xfl * 100)) {
@@ -82,7 +83,8 @@ void RenderNextSectorTagItem(
     }
 
     // ✅ Check Destination LOAs
-    for (const auto& entry : destinationLoas) {
+    for (const LOAEntry* pe : destinationLoas) {
+        const LOAEntry& entry = *pe;
         if (matches(entry)) {
             if (clearedAltitude > entry.xfl * 100) {
                 if (!entry.nextSectors.empty()) {
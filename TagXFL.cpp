@@ -19,24 +19,13 @@ static void FormatFL3(char sItemString[16], int altitudeFeet)
     _snprintf_s(sItemString, 16, _TRUNCATE, "%03d", fl);
 }
 
-namespace {
-    struct XflCoordHeuristicState {
-        int baselineValue = 0;
-        int pendingValue = 0;
-        bool hasBaseline = false;
-        bool pendingActive = false;
-    };
-
-    static std::unordered_map<std::string, XflCoordHeuristicState> g_xflHeuristic;
-}
-
 static bool TryGetLiveCoordAltitude(
     EuroScopePlugIn::CFlightPlan flightPlan,
     int& outAlt,
     int& outState)
 {
-    const std::string callsign = flightPlan.GetCallsign();
-    XflCoordHeuristicState& st = g_xflHeuristic[callsign];
+    // Learned baseline/pending values live in the flight's FlightState record
+    XflCoordHeuristicState& st = pMyPlugIn->GetFlightState(flightPlan).xfl;
 
     outAlt = flightPlan.GetExitCoordinationAltitude();
     outState = flightPlan.GetExitCoordinationAltitudeState();
@@ -159,13 +148,13 @@ void RenderXFLTagItem(
         return;
     }
 
-    const LOAEntry* matched = plugin.currentFrameMatchedEntry;
-    if (matched && !plugin.IsLoaEntryPointerValid(matched)) matched = nullptr;
+    const LOAEntry* matched = ctx.matchedEntry;
+    if (matched && !pMyPlugIn->IsLoaEntryPointerValid(matched)) matched = nullptr;
     int clearedAltitude = ctx.clearedAltitude;
     int finalAltitude = ctx.finalAltitude;
 
-    if (plugin.IsAORDestination(ctx.destination) &&
-        plugin.IsAnyAORHostOnline(plugin.currentFrameOnlineControllers)) {
+    if (pMyPlugIn->IsAORDestination(ctx.destination) &&
+        pMyPlugIn->IsAnyAORHostOnline(pMyPlugIn->currentFrameOnlineControllers)) {
         sItemString[0] = '\0';
         return;
     }
@@ -230,7 +219,7 @@ void RenderXFLDetailedTagItem(
     double* pFontSize,
     const PerAircraftFrameData& ctx)
 {
-    if (!flightPlan.IsValid() || !plugin.IsLOARelevantState(flightPlan.GetState())) {
+    if (!flightPlan.IsValid() || !pMyPlugIn->IsLOARelevantState(flightPlan.GetState())) {
         strncpy_s(sItemString, 16, "XFL", _TRUNCATE);
         return;
     }
@@ -248,8 +237,8 @@ void RenderXFLDetailedTagItem(
 
     int finalAltitude = ctx.finalAltitude;
 
-    if (plugin.IsAORDestination(ctx.destination) &&
-        plugin.IsAnyAORHostOnline(plugin.currentFrameOnlineControllers)) {
+    if (pMyPlugIn->IsAORDestination(ctx.destination) &&
+        pMyPlugIn->IsAnyAORHostOnline(pMyPlugIn->currentFrameOnlineControllers)) {
         strncpy_s(sItemString, 16, "XFL", _TRUNCATE);
         return;
     }
@@ -261,8 +250,8 @@ void RenderXFLDetailedTagItem(
         return;
     }
 
-    const LOAEntry* finalMatch = plugin.currentFrameMatchedEntry;
-    if (finalMatch && !plugin.IsLoaEntryPointerValid(finalMatch)) finalMatch = nullptr;
+    const LOAEntry* finalMatch = ctx.matchedEntry;
+    if (finalMatch && !pMyPlugIn->IsLoaEntryPointerValid(finalMatch)) finalMatch = nullptr;
 
     if (finalMatch) {
         if (!finalMatch->xflText.empty()) {